@@ -9,14 +9,44 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#define HAVE_EPOLL 1
+#define HAVE_EVENTFD 1
+#endif
+#if defined(__linux__) || defined(__FreeBSD__)
+#define HAVE_PPOLL 1
+#define HAVE_SIGQUEUE 1
+#endif
+#if defined(__linux__) || defined(__FreeBSD__)
+#include <spawn.h>
+#define HAVE_SPAWN_HELPER 1
+extern char **environ;
+#endif
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#define HAVE_VFORK_SPAWN 1
+#define HAVE_PIDFD_SPAWN 1
+#ifndef CLONE_PIDFD
+#define CLONE_PIDFD 0x00001000
+#endif
+#endif
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
 #include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
@@ -25,10 +55,10 @@
 #define OR_DIE 2
 
 struct socketalarm;
+struct socketalarm_program;
 
 #include "SocketAlarm_util.h"
 #include "SocketAlarm_action.h"
-#include "pollfd_rbhash.h"
 #include "SocketAlarm_watcher.h"
 
 #define EVENT_SHUT      0x01
@@ -44,41 +74,65 @@ struct socketalarm;
 #endif
 
 struct socketalarm {
+   int id;            // unique within the process, sent by 'sigqueue'
    int list_ofs;      // position within watch_list, initially -1 until activated
+   struct socketalarm *fd_next; // next alarm watching the same fd
    int watch_fd;
    dev_t watch_fd_dev;
    ino_t watch_fd_ino;
+   uint64_t watch_fd_cookie; // SO_COOKIE, or 0 if unavailable
    int event_mask;
    int action_count;
    SV *owner;
    AV *actions_av;    // lazy-built
+   struct socketalarm_program *program; // holds the action data, if shared
+   size_t alloc_size;       // as given to block_pool_alloc
    bool unwaitable;         //
+   bool peer_shut;          // peer has shut down its side (only tracked while unwaitable)
    int cur_action;          // used during execution
+   bool executing;          // claimed by an executor thread, or queued for one
+   struct socketalarm *exec_next; // next in the executor queue
+   bool fired_queued;       // in the queue returned by drain_triggered
+   struct socketalarm *fired_next; // next in that queue
    struct timespec wake_ts; //
+   int timer_idx;           // position within watch_timers, or -1
+   struct timespec recheck_ts; // when to next poll the socket, if it can't be waited
+   double recheck_interval; // current delay between rechecks, in seconds
+   struct action actions[];
+};
+
+// Actions parsed once by IO::SocketAlarm::Actions.  Alarms created from it copy
+// 'actions' (which also hold the per-alarm state of 'spawn') but point to the
+// strings, argv and addresses in its aux buffer, so it is refcounted and lives
+// until the last of those alarms is freed.  Only Perl's thread creates and
+// frees alarms and programs, so the refcount needs no lock.
+struct socketalarm_program {
+   int refcount;
+   int action_count;
+   AV *actions_av;    // lazy-built
    struct action actions[];
 };
 
+// Perl's thread reads cur_action without taking watch_list_mutex, so that
+// checking an alarm's status never waits for the watch or executor threads.
+// Every write publishes it with release semantics, and reads acquire it.
+#ifdef __ATOMIC_ACQUIRE
+#define socketalarm_cur_action_set(sa, v) __atomic_store_n(&(sa)->cur_action, (v), __ATOMIC_RELEASE)
+#define socketalarm_cur_action_get(sa)    __atomic_load_n(&(sa)->cur_action, __ATOMIC_ACQUIRE)
+#else
+#define socketalarm_cur_action_set(sa, v) ((sa)->cur_action= (v))
+#define socketalarm_cur_action_get(sa)    (*(volatile int*) &(sa)->cur_action)
+#endif
+
 static void socketalarm_exec_actions(struct socketalarm *sa);
 
 #include "SocketAlarm_util.c"
 #include "SocketAlarm_action.c"
 #include "SocketAlarm_watcher.c"
 
-struct socketalarm *
-socketalarm_new(int watch_fd, struct stat *statbuf, int event_mask, SV **action_spec, size_t spec_count) {
-   size_t n_actions= 0, aux_len= 0, len_before_aux;
-   struct socketalarm *self= NULL;
+static int socketalarm_last_id= 0;
 
-   parse_actions(action_spec, spec_count, NULL, &n_actions, NULL, &aux_len);
-   // buffer needs aligned to pointer, which sizeof(struct action) is not guaranteed to be
-   len_before_aux= sizeof(struct socketalarm) + n_actions * sizeof(struct action);
-   len_before_aux += sizeof(void*)-1;
-   len_before_aux &= ~(sizeof(void*)-1);
-   self= (struct socketalarm *) safecalloc(1, len_before_aux + aux_len);
-   // second call should succeed, because we gave it back it's own requested buffer sizes.
-   // could fail if user did something evil like a tied scalar that changes length...
-   if (!parse_actions(action_spec, spec_count, self->actions, &n_actions, ((char*)self) + len_before_aux, &aux_len))
-      croak("BUG: buffers not large enough for parse_actions");
+static void socketalarm_init(struct socketalarm *self, int watch_fd, struct stat *statbuf, int event_mask, size_t n_actions) {
    // If user requests EVENT_SHUT and not available on the platform, warn and downgrade to EVENT_EOF
    if (!(EVENT_DEFAULTS & EVENT_SHUT) && (event_mask & EVENT_SHUT) && !(event_mask & EVENT_EOF)) {
       SV *warned= get_sv("IO::SocketAlarm::_warned_EVENT_SHUT_unavail", GV_ADD);
@@ -88,53 +142,137 @@ socketalarm_new(int watch_fd, struct stat *statbuf, int event_mask, SV **action_
       }
       event_mask |= EVENT_EOF;
    }
+   self->id= ++socketalarm_last_id;
    self->watch_fd= watch_fd;
    self->watch_fd_dev= statbuf->st_dev;
    self->watch_fd_ino= statbuf->st_ino;
+   self->watch_fd_cookie= get_socket_cookie(watch_fd);
    self->event_mask= event_mask;
    self->actions_av= NULL;
    self->action_count= n_actions;
    self->list_ofs= -1; // initially not in the watch list
+   self->timer_idx= -1;
    self->owner= NULL;
+}
+
+struct socketalarm *
+socketalarm_new(int watch_fd, struct stat *statbuf, int event_mask, SV **action_spec, size_t spec_count) {
+   size_t n_actions= 0, aux_len= 0, len_before_aux;
+   struct socketalarm *self= NULL;
+
+   parse_actions(action_spec, spec_count, NULL, &n_actions, NULL, &aux_len);
+   // buffer needs aligned to pointer, which sizeof(struct action) is not guaranteed to be
+   len_before_aux= sizeof(struct socketalarm) + n_actions * sizeof(struct action);
+   len_before_aux += sizeof(void*)-1;
+   len_before_aux &= ~(sizeof(void*)-1);
+   if (!(self= (struct socketalarm *) block_pool_alloc(len_before_aux + aux_len)))
+      croak("Out of memory");
+   self->alloc_size= len_before_aux + aux_len;
+   // second call should succeed, because we gave it back it's own requested buffer sizes.
+   // could fail if user did something evil like a tied scalar that changes length...
+   if (!parse_actions(action_spec, spec_count, self->actions, &n_actions, ((char*)self) + len_before_aux, &aux_len))
+      croak("BUG: buffers not large enough for parse_actions");
+   socketalarm_init(self, watch_fd, statbuf, event_mask, n_actions);
+   return self;
+}
+
+struct socketalarm_program *
+socketalarm_program_new(SV **action_spec, size_t spec_count) {
+   size_t n_actions= 0, aux_len= 0, len_before_aux;
+   struct socketalarm_program *self= NULL;
+
+   parse_actions(action_spec, spec_count, NULL, &n_actions, NULL, &aux_len);
+   len_before_aux= sizeof(struct socketalarm_program) + n_actions * sizeof(struct action);
+   len_before_aux += sizeof(void*)-1;
+   len_before_aux &= ~(sizeof(void*)-1);
+   self= (struct socketalarm_program *) safecalloc(1, len_before_aux + aux_len);
+   if (!parse_actions(action_spec, spec_count, self->actions, &n_actions, ((char*)self) + len_before_aux, &aux_len))
+      croak("BUG: buffers not large enough for parse_actions");
+   self->action_count= n_actions;
+   self->refcount= 1; // for the perl object
+   return self;
+}
+
+// Create an alarm that runs the actions of 'prog', without parsing or copying
+// any of the strings they refer to.
+struct socketalarm *
+socketalarm_new_from_program(int watch_fd, struct stat *statbuf, int event_mask, struct socketalarm_program *prog) {
+   size_t size= sizeof(struct socketalarm) + prog->action_count * sizeof(struct action);
+   struct socketalarm *self= (struct socketalarm *) block_pool_alloc(size);
+   if (!self)
+      croak("Out of memory");
+   self->alloc_size= size;
+   memcpy(self->actions, prog->actions, prog->action_count * sizeof(struct action));
+   socketalarm_init(self, watch_fd, statbuf, event_mask, prog->action_count);
+   self->program= prog;
+   ++prog->refcount;
    return self;
 }
 
+void socketalarm_program_release(struct socketalarm_program *prog) {
+   if (--prog->refcount == 0) {
+      if (prog->actions_av)
+         SvREFCNT_dec((SV*) prog->actions_av);
+      Safefree(prog);
+   }
+}
+
 void socketalarm_exec_actions(struct socketalarm *self) {
-   bool resume= self->cur_action >= 0;
+   // wake_ts is only set while paused at a 'sleep'
+   bool resume= self->wake_ts.tv_nsec != -1;
    struct timespec now_ts= { 0, -1 };
-   if (!resume)
-      self->cur_action= 0;
-   while (self->cur_action < self->action_count) {
-      if (!execute_action(self->actions + self->cur_action, resume, &now_ts, self))
+   // Executors run this without the mutex, so work from a local copy and only
+   // publish it, rather than reading cur_action back after Perl's thread may
+   // have seen the alarm finish.
+   int i= socketalarm_cur_action_get(self);
+   if (i < 0)
+      socketalarm_cur_action_set(self, i= 0);
+   while (i < self->action_count) {
+      if (!execute_action(self->actions + i, resume, &now_ts, self))
          break;
       resume= false;
-      ++self->cur_action;
+      socketalarm_cur_action_set(self, ++i);
    }
 }
 
-static void socketalarm__build_actions(struct socketalarm *self) {
+static AV* build_actions_av(struct action *actions, int action_count) {
+   AV *actions_av= newAV();
    Size_t i;
+   av_extend(actions_av, action_count-1);
+   for (i= 0; i < action_count; i++) {
+      AV *act_spec= newAV();
+      inflate_action(actions+i, act_spec);
+      SvREADONLY_on((SV*) act_spec);
+      av_push(actions_av, newRV_noinc((SV*) act_spec));
+   }
+   SvREADONLY_on((SV*) actions_av);
+   return actions_av;
+}
+
+static void socketalarm__build_actions(struct socketalarm *self) {
    if (!self->actions_av) {
-      self->actions_av= newAV();
-      av_extend(self->actions_av, self->action_count-1);
-      for (i= 0; i < self->action_count; i++) {
-         AV *act_spec= newAV();
-         inflate_action(self->actions+i, act_spec);
-         SvREADONLY_on((SV*) act_spec);
-         av_push(self->actions_av, newRV_noinc((SV*) act_spec));
+      // Alarms of the same program share one copy
+      if (self->program) {
+         if (!self->program->actions_av)
+            self->program->actions_av= build_actions_av(self->program->actions, self->program->action_count);
+         self->actions_av= (AV*) SvREFCNT_inc((SV*) self->program->actions_av);
       }
-      SvREADONLY_on((SV*) self->actions_av);
+      else
+         self->actions_av= build_actions_av(self->actions, self->action_count);
    }
 }
 
 void socketalarm_free(struct socketalarm *sa) {
    // Must remove the socketalarm from the active list, if present
    watch_list_remove(sa);
+   watch_list_forget(sa);
    // Release reference to lazy-built action AV
    if (sa->actions_av)
       SvREFCNT_dec((SV*) sa->actions_av);
+   if (sa->program)
+      socketalarm_program_release(sa->program);
    // was allocated as one chunk
-   Safefree(sa);
+   block_pool_free(sa, sa->alloc_size);
 }
 
 /* Return an SV array of an AV.
@@ -243,6 +381,18 @@ static void attach_magic_socketalarm(SV *obj_inner_sv, struct socketalarm *sa) {
 #endif
 }
 
+// Return a temporary array of the socketalarm of each object, croaking if any
+// is not an alarm.
+static struct socketalarm** unwrap_socketalarm_list(SV **objs, int n) {
+   struct socketalarm **alarms;
+   int i;
+   Newx(alarms, n? n : 1, struct socketalarm *);
+   SAVEFREEPV(alarms);
+   for (i= 0; i < n; i++)
+      alarms[i]= get_magic_socketalarm(objs[i], OR_DIE);
+   return alarms;
+}
+
 // Return existing Watch object, or create a new one.
 // Returned SV has a non-mortal refcount, which is what the typemap
 // wants for returning a "struct socketalarm*" to perl-land
@@ -263,6 +413,51 @@ static SV* wrap_socketalarm(struct socketalarm *sa) {
    return obj;
 }
 
+// destructor for Actions objects
+static int socketalarm_program_magic_free(pTHX_ SV* sv, MAGIC* mg) {
+   if (mg->mg_ptr) {
+      socketalarm_program_release((struct socketalarm_program*) mg->mg_ptr);
+      mg->mg_ptr= NULL;
+   }
+   return 0;
+}
+
+// magic table for Actions objects
+static MGVTBL socketalarm_program_magic_vt= {
+   0, /* get */
+   0, /* write */
+   0, /* length */
+   0, /* clear */
+   socketalarm_program_magic_free,
+   0, /* copy */
+   socketalarm_magic_dup
+#ifdef MGf_LOCAL
+   ,0
+#endif
+};
+
+// Return the program attached to a perl Actions object, or NULL if 'obj' isn't one.
+static struct socketalarm_program*
+get_magic_socketalarm_program(SV *obj, int flags) {
+   MAGIC* magic;
+   if (sv_isobject(obj) && SvMAGICAL(SvRV(obj))
+      && (magic= mg_findext(SvRV(obj), PERL_MAGIC_ext, &socketalarm_program_magic_vt)))
+      return (struct socketalarm_program*) magic->mg_ptr;
+   if (flags & OR_DIE)
+      croak("Not an IO::SocketAlarm::Actions object");
+   return NULL;
+}
+
+static void attach_magic_socketalarm_program(SV *obj_inner_sv, struct socketalarm_program *prog) {
+   MAGIC *magic;
+   magic= sv_magicext(obj_inner_sv, NULL, PERL_MAGIC_ext, &socketalarm_program_magic_vt, (const char*) prog, 0);
+#ifdef USE_ITHREADS
+   magic->mg_flags |= MGf_DUP;
+#else
+   (void)magic;
+#endif
+}
+
 #define EXPORT_ENUM(x) newCONSTSUB(stash, #x, new_enum_dualvar(aTHX_ x, newSVpvs_share(#x)))
 static SV * new_enum_dualvar(pTHX_ IV ival, SV *name) {
    SvUPGRADE(name, SVt_PVNV);
@@ -289,6 +484,7 @@ _init_socketalarm(self, sock_sv, eventmask_sv, actions_sv)
       int eventmask= EVENT_DEFAULTS;
       struct stat statbuf;
       struct socketalarm *sa;
+      struct socketalarm_program *prog;
       SV **action_list= NULL;
       SSize_t n_actions= 0;
    PPCODE:
@@ -300,15 +496,27 @@ _init_socketalarm(self, sock_sv, eventmask_sv, actions_sv)
          croak("Not an open socket");
       if (eventmask_sv && SvOK(eventmask_sv))
          eventmask= SvIV(eventmask_sv);
-      if (actions_sv && SvOK(actions_sv)) {
-         action_list= unwrap_array(actions_sv, &n_actions);
-         if (!action_list)
-            croak("Actions must be an arrayref (or undefined)");
+      if ((prog= get_magic_socketalarm_program(actions_sv, 0)))
+         sa= socketalarm_new_from_program(sock_fd, &statbuf, eventmask, prog);
+      else {
+         if (actions_sv && SvOK(actions_sv)) {
+            action_list= unwrap_array(actions_sv, &n_actions);
+            if (!action_list)
+               croak("Actions must be an arrayref, IO::SocketAlarm::Actions object, or undefined");
+         }
+         sa= socketalarm_new(sock_fd, &statbuf, eventmask, action_list, n_actions);
       }
-      sa= socketalarm_new(sock_fd, &statbuf, eventmask, action_list, n_actions);
       attach_magic_socketalarm(SvRV(self), sa);
       XSRETURN(1); // return $self
 
+int
+id(alarm)
+   struct socketalarm *alarm
+   CODE:
+      RETVAL= alarm->id;
+   OUTPUT:
+      RETVAL
+
 int
 socket(alarm)
    struct socketalarm *alarm
@@ -334,6 +542,22 @@ actions(alarm)
       ST(0)= sv_2mortal(newRV_inc((SV*) alarm->actions_av));
       XSRETURN(1);
 
+void
+action_results(alarm)
+   struct socketalarm *alarm
+   INIT:
+      AV *results= newAV();
+      int *status, i;
+   PPCODE:
+      ST(0)= sv_2mortal(newRV_noinc((SV*) results));
+      Newx(status, alarm->action_count, int);
+      SAVEFREEPV(status);
+      watch_list_item_get_results(alarm, status);
+      av_extend(results, alarm->action_count-1);
+      for (i= 0; i < alarm->action_count; i++)
+         av_push(results, status[i] >= 0? newSViv(status[i]) : newSV(0));
+      XSRETURN(1);
+
 int
 action_count(alarm)
    struct socketalarm *alarm
@@ -350,6 +574,28 @@ cur_action(alarm)
    OUTPUT:
       RETVAL
 
+bool
+triggered(alarm)
+   struct socketalarm *alarm
+   INIT:
+      int cur_action;
+   CODE:
+      watch_list_item_get_status(alarm, &cur_action);
+      RETVAL= cur_action >= 0;
+   OUTPUT:
+      RETVAL
+
+bool
+finished(alarm)
+   struct socketalarm *alarm
+   INIT:
+      int cur_action;
+   CODE:
+      watch_list_item_get_status(alarm, &cur_action);
+      RETVAL= cur_action >= alarm->action_count;
+   OUTPUT:
+      RETVAL
+
 bool
 start(alarm)
    struct socketalarm *alarm
@@ -366,6 +612,29 @@ cancel(alarm)
    OUTPUT:
       RETVAL
 
+void
+rearm(self, sock_sv)
+   SV *self
+   SV *sock_sv
+   INIT:
+      struct socketalarm *alarm= get_magic_socketalarm(self, OR_DIE);
+      int sock_fd= fileno_from_sv(sock_sv);
+      struct stat statbuf;
+   PPCODE:
+      if (!(sock_fd >= 0 && fstat(sock_fd, &statbuf) == 0 && S_ISSOCK(statbuf.st_mode)))
+         croak("Not an open socket");
+      watch_list_rearm(alarm, sock_fd, &statbuf, get_socket_cookie(sock_fd));
+      XSRETURN(1); // return $self
+
+void
+reset(self)
+   SV *self
+   INIT:
+      struct socketalarm *alarm= get_magic_socketalarm(self, OR_DIE);
+   PPCODE:
+      watch_list_rearm(alarm, -1, NULL, 0);
+      XSRETURN(1); // return $self
+
 SV*
 stringify(alarm)
    struct socketalarm *alarm
@@ -389,11 +658,159 @@ stringify(alarm)
    OUTPUT:
       RETVAL
 
+void
+recheck_interval(class_or_obj, ...)
+   SV *class_or_obj
+   PPCODE:
+      PERL_UNUSED_VAR(class_or_obj);
+      if (items > 3)
+         croak("Expected (min, max) seconds");
+      if (items > 1)
+         watch_recheck_interval_set(SvNV(ST(1)), items > 2? SvNV(ST(2)) : SvNV(ST(1)));
+      EXTEND(SP, 2);
+      PUSHs(sv_2mortal(newSVnv(watch_recheck_min)));
+      PUSHs(sv_2mortal(newSVnv(watch_recheck_max)));
+
+int
+start_all(class_or_obj, ...)
+   SV *class_or_obj
+   CODE:
+      PERL_UNUSED_VAR(class_or_obj);
+      RETVAL= watch_list_add_all(unwrap_socketalarm_list(&ST(1), items-1), items-1);
+   OUTPUT:
+      RETVAL
+
+int
+cancel_all(class_or_obj, ...)
+   SV *class_or_obj
+   CODE:
+      PERL_UNUSED_VAR(class_or_obj);
+      RETVAL= watch_list_remove_all(unwrap_socketalarm_list(&ST(1), items-1), items-1);
+   OUTPUT:
+      RETVAL
+
+void
+pool_stats(class_or_obj)
+   SV *class_or_obj
+   INIT:
+      struct block_pool_stats stats;
+      HV *hv= newHV();
+   PPCODE:
+      PERL_UNUSED_VAR(class_or_obj);
+      block_pool_get_stats(&stats);
+      ST(0)= sv_2mortal(newRV_noinc((SV*) hv));
+      hv_stores(hv, "hits",     newSVuv(stats.hits));
+      hv_stores(hv, "misses",   newSVuv(stats.misses));
+      hv_stores(hv, "released", newSVuv(stats.released));
+      hv_stores(hv, "cached",   newSVuv(stats.cached));
+      XSRETURN(1);
+
+int
+start_spawn_helper(class_or_obj)
+   SV *class_or_obj
+   CODE:
+      PERL_UNUSED_VAR(class_or_obj);
+#ifdef HAVE_SPAWN_HELPER
+      RETVAL= spawn_helper_start();
+#else
+      croak("The spawn helper is not supported on this platform");
+#endif
+   OUTPUT:
+      RETVAL
+
+const char*
+watch_backend(class_or_obj, name=NULL)
+   SV *class_or_obj
+   const char *name
+   CODE:
+      PERL_UNUSED_VAR(class_or_obj);
+      if (name)
+         watch_backend_set(name);
+      RETVAL= watch_backend_name();
+   OUTPUT:
+      RETVAL
+
+int
+notify_fd(class_or_obj)
+   SV *class_or_obj
+   CODE:
+      PERL_UNUSED_VAR(class_or_obj);
+      RETVAL= watch_notify_fd_get();
+   OUTPUT:
+      RETVAL
+
+void
+drain_triggered(class_or_obj)
+   SV *class_or_obj
+   INIT:
+      struct socketalarm *fired[64];
+      int n, i;
+   PPCODE:
+      PERL_UNUSED_VAR(class_or_obj);
+      while ((n= watch_fired_take(fired, 64)) > 0) {
+         EXTEND(SP, n);
+         for (i= 0; i < n; i++)
+            if (fired[i]->owner)
+               PUSHs(sv_2mortal(wrap_socketalarm(fired[i])));
+      }
+
+void
+_fd_closed(fd)
+   int fd
+   PPCODE:
+      watch_fd_closed(fd);
+
 void
 _terminate_all()
    PPCODE:
       shutdown_watch_thread();
 
+MODULE = IO::SocketAlarm               PACKAGE = IO::SocketAlarm::Actions
+
+void
+new(class, ...)
+   SV *class
+   INIT:
+      struct socketalarm_program *prog;
+      HV *hv;
+      SV *obj;
+   PPCODE:
+      prog= socketalarm_program_new(&(ST(1)), items - 1);
+      hv= newHV();
+      obj= sv_2mortal(newRV_noinc((SV*) hv));
+      sv_bless(obj, gv_stashsv(class, GV_ADD));
+      attach_magic_socketalarm_program((SV*) hv, prog);
+      ST(0)= obj;
+      XSRETURN(1);
+
+void
+actions(self)
+   SV *self
+   INIT:
+      struct socketalarm_program *prog= get_magic_socketalarm_program(self, OR_DIE);
+   PPCODE:
+      if (!prog->actions_av)
+         prog->actions_av= build_actions_av(prog->actions, prog->action_count);
+      ST(0)= sv_2mortal(newRV_inc((SV*) prog->actions_av));
+      XSRETURN(1);
+
+int
+action_count(self)
+   SV *self
+   CODE:
+      RETVAL= get_magic_socketalarm_program(self, OR_DIE)->action_count;
+   OUTPUT:
+      RETVAL
+
+int
+alarm_count(self)
+   SV *self
+   CODE:
+      // the perl object holds one reference
+      RETVAL= get_magic_socketalarm_program(self, OR_DIE)->refcount - 1;
+   OUTPUT:
+      RETVAL
+
 MODULE = IO::SocketAlarm               PACKAGE = IO::SocketAlarm::Util
 
 struct socketalarm *
@@ -404,6 +821,7 @@ socketalarm(sock_sv, ...)
       int eventmask= EVENT_DEFAULTS;
       int action_ofs= 1;
       struct stat statbuf;
+      struct socketalarm_program *prog;
    CODE:
       if (!(sock_fd >= 0 && fstat(sock_fd, &statbuf) == 0 && S_ISSOCK(statbuf.st_mode)))
          croak("Not an open socket");
@@ -414,11 +832,37 @@ socketalarm(sock_sv, ...)
             action_ofs++;
          }
       }
-      RETVAL= socketalarm_new(sock_fd, &statbuf, eventmask, &(ST(action_ofs)), items - action_ofs);
+      if (items - action_ofs == 1 && (prog= get_magic_socketalarm_program(ST(action_ofs), 0)))
+         RETVAL= socketalarm_new_from_program(sock_fd, &statbuf, eventmask, prog);
+      else
+         RETVAL= socketalarm_new(sock_fd, &statbuf, eventmask, &(ST(action_ofs)), items - action_ofs);
       watch_list_add(RETVAL);
    OUTPUT:
       RETVAL
 
+void
+capture_sigqueue(sig_sv)
+   SV *sig_sv
+   PPCODE:
+#ifdef HAVE_SIGQUEUE
+      sigqueue_capture(parse_signal(sig_sv));
+#else
+      croak("sigqueue is not supported on this platform");
+#endif
+
+void
+sigqueue_values(sig_sv)
+   SV *sig_sv
+   INIT:
+      int values[64], n, i;
+   PPCODE:
+#ifdef HAVE_SIGQUEUE
+      n= sigqueue_take(parse_signal(sig_sv), values, 64);
+      EXTEND(SP, n);
+      for (i= 0; i < n; i++)
+         PUSHs(sv_2mortal(newSViv(values[i])));
+#endif
+
 bool
 is_socket(fd_sv)
    SV *fd_sv
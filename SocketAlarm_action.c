@@ -67,6 +67,54 @@ bool parse_actions(SV **spec, int n_spec, struct action *actions, size_t *n_acti
             common_op= ACT_EXEC;
             goto parse_run_common;
          }
+         if (strcmp(act_name, "send") == 0) {
+            const char *addr, *payload;
+            STRLEN addr_len, len;
+            double timeout= 2;
+            if (n_el != 3 && n_el != 4)
+               croak("Expected 2 or 3 parameters for 'send' action");
+            el= av_fetch(action_spec, 1, 0);
+            if (!el || !*el || !SvOK(*el))
+               croak("Expected socket address as first parameter to 'send'");
+            addr= SvPVbyte(*el, addr_len);
+            if (!(addr_len >= offsetof(struct sockaddr, sa_data) && (
+                  (((struct sockaddr*)addr)->sa_family == AF_INET && addr_len >= sizeof(struct sockaddr_in))
+               #ifdef AF_INET6
+               || (((struct sockaddr*)addr)->sa_family == AF_INET6 && addr_len >= sizeof(struct sockaddr_in6))
+               #endif
+               || (((struct sockaddr*)addr)->sa_family == AF_UNIX && addr_len <= sizeof(struct sockaddr_un))
+            )))
+               croak("'send' address must be a packed inet, inet6, or unix socket address");
+            el= av_fetch(action_spec, 2, 0);
+            if (!el || !*el || !SvOK(*el))
+               croak("Expected payload bytes as second parameter to 'send'");
+            payload= SvPVbyte(*el, len);
+            if (n_el == 4 && (el= av_fetch(action_spec, 3, 0)) && *el && SvOK(*el)) {
+               if (!looks_like_number(*el) || SvNV(*el) <= 0)
+                  croak("Expected positive number of seconds for 'send' timeout");
+               timeout= SvNV(*el);
+            }
+            // Align to pointer boundary within aux_buf, for the sockaddr
+            aux_pos += sizeof(void*) - 1;
+            aux_pos &= ~(sizeof(void*) - 1);
+            if (action_pos < *n_actions) {
+               actions[action_pos].op= ACT_SEND;
+               actions[action_pos].orig_idx= spec_i;
+               actions[action_pos].act.snd.addr= (struct sockaddr*) (aux_buf + aux_pos);
+               actions[action_pos].act.snd.addr_len= addr_len;
+               actions[action_pos].act.snd.buf= aux_buf + aux_pos + addr_len;
+               actions[action_pos].act.snd.len= len;
+               actions[action_pos].act.snd.timeout= timeout;
+               actions[action_pos].act.snd.linger_fd= -1;
+            }
+            if (aux_pos + addr_len + len <= *aux_len) {
+               memcpy(aux_buf + aux_pos, addr, addr_len);
+               memcpy(aux_buf + aux_pos + addr_len, payload, len);
+            }
+            aux_pos += addr_len + len;
+            ++action_pos;
+            continue;
+         }
       case 5:
          if (strcmp(act_name, "sleep") == 0) {
             if (n_el != 2)
@@ -86,6 +134,39 @@ bool parse_actions(SV **spec, int n_spec, struct action *actions, size_t *n_acti
             common_op= ACT_x_CLOSE;
             goto parse_close_common;
          }
+         if (strcmp(act_name, "spawn") == 0) {
+            common_op= ACT_SPAWN;
+            goto parse_run_common;
+         }
+         if (strcmp(act_name, "write") == 0) {
+            int fd;
+            const char *str;
+            STRLEN len;
+            if (n_el != 3)
+               croak("Expected 2 parameters for 'write' action");
+            el= av_fetch(action_spec, 1, 0);
+            if (!el || !*el || !SvOK(*el))
+               croak("Expected file descriptor or handle as first parameter to 'write'");
+            fd= SvROK(*el)? fileno_from_sv(*el) : looks_like_number(*el)? SvIV(*el) : -1;
+            if (fd < 0 || fd >= 0x10000)
+               croak("Invalid file descriptor for 'write'");
+            el= av_fetch(action_spec, 2, 0);
+            if (!el || !*el || !SvOK(*el))
+               croak("Expected bytes as second parameter to 'write'");
+            str= SvPVbyte(*el, len);
+            if (action_pos < *n_actions) {
+               actions[action_pos].op= ACT_WRITE;
+               actions[action_pos].orig_idx= spec_i;
+               actions[action_pos].act.wr.fd= fd;
+               actions[action_pos].act.wr.buf= aux_buf + aux_pos;
+               actions[action_pos].act.wr.len= len;
+            }
+            if (aux_pos + len <= *aux_len)
+               memcpy(aux_buf + aux_pos, str, len);
+            aux_pos += len;
+            ++action_pos;
+            continue;
+         }
       case 6:
          // The repeat feature opens the possibility of infinite busy-loops,
          // and probably creates more problems than it solves.
@@ -127,6 +208,50 @@ bool parse_actions(SV **spec, int n_spec, struct action *actions, size_t *n_acti
             common_op= ACT_x_SHUT_RW;
             goto parse_close_common;
          }
+      case 8:
+         if (strcmp(act_name, "sigqueue") == 0) {
+            if (n_el < 2 || n_el > 3)
+               croak("Expected 1 or 2 parameters for 'sigqueue' action");
+            el= av_fetch(action_spec, 1, 0);
+            if (!el || !*el || !SvOK(*el))
+               croak("Expected Signal as first parameter to 'sigqueue'");
+            common_signal= parse_signal(*el);
+            el= n_el == 3? av_fetch(action_spec, 2, 0) : NULL;
+            if (el && *el && SvOK(*el) && !looks_like_number(*el))
+               croak("Expected integer value as second parameter to 'sigqueue'");
+            if (action_pos < *n_actions) {
+               actions[action_pos].op= ACT_SIGQUEUE;
+               actions[action_pos].orig_idx= spec_i;
+               actions[action_pos].act.sigq.pid= getpid();
+               actions[action_pos].act.sigq.signal= common_signal;
+               actions[action_pos].act.sigq.use_id= !(el && *el && SvOK(*el));
+               actions[action_pos].act.sigq.value= actions[action_pos].act.sigq.use_id? 0 : SvIV(*el);
+            }
+            ++action_pos;
+            continue;
+         }
+      case 10:
+         if (strcmp(act_name, "sig_thread") == 0) {
+            if (n_el > 2)
+               croak("Too many parameters for 'sig_thread' action");
+            common_signal= (n_el == 2 && (el= av_fetch(action_spec, 1, 0)) != NULL && SvOK(*el))?
+               parse_signal(*el) : SIGALRM;
+            // Target the thread creating the alarm, which is perl's
+            if (action_pos < *n_actions) {
+               actions[action_pos].op= ACT_TKILL;
+               actions[action_pos].orig_idx= spec_i;
+               actions[action_pos].act.tkill.signal= common_signal;
+               actions[action_pos].act.tkill.pid= getpid();
+               #ifdef SYS_tgkill
+               actions[action_pos].act.tkill.tid= syscall(SYS_gettid);
+               #else
+               actions[action_pos].act.tkill.tid= 0;
+               #endif
+               actions[action_pos].act.tkill.thread= pthread_self();
+            }
+            ++action_pos;
+            continue;
+         }
       default:
          croak("Unknown command '%s' in action list", act_name);
       }
@@ -141,7 +266,7 @@ bool parse_actions(SV **spec, int n_spec, struct action *actions, size_t *n_acti
          }
          ++action_pos;
       }
-      if (0) parse_run_common: { // arrive from 'run' and 'exec'
+      if (0) parse_run_common: { // arrive from 'run', 'spawn' and 'exec'
          char **argv= NULL, *str;
          STRLEN len;
          int j, argc= n_el-1;
@@ -177,6 +302,9 @@ bool parse_actions(SV **spec, int n_spec, struct action *actions, size_t *n_acti
             actions[action_pos].orig_idx= spec_i;
             actions[action_pos].act.run.argc= argc;
             actions[action_pos].act.run.argv= argv;
+            actions[action_pos].act.run.pid= 0;
+            actions[action_pos].act.run.pidfd= -1;
+            actions[action_pos].act.run.status= -1;
          }
          ++action_pos;
       }
@@ -254,6 +382,364 @@ bool parse_actions(SV **spec, int n_spec, struct action *actions, size_t *n_acti
    return success;
 }
 
+#ifdef HAVE_VFORK_SPAWN
+// Start a command with stdin on /dev/null, not as a child of this process.
+// This is the classic double-fork, but neither step copies this process's
+// page tables: the intermediate process comes from vfork, which borrows this
+// process's memory (and suspends this thread) until it exits, and it uses
+// posix_spawn (clone with CLONE_VM|CLONE_VFORK on Linux) to start the command.
+// The intermediate can't touch anything but its own stack and fd table, so
+// it uses no malloc or stdio.  Returns the intermediate's exit status.
+static int run_detached(char **argv) {
+   pid_t child;
+   int status= -1;
+   if ((child= vfork()) < 0) {
+      perror("vfork");
+      return -1;
+   }
+   else if (child == 0) {
+      posix_spawnattr_t attr;
+      sigset_t nosigs;
+      pid_t gchild;
+      int err;
+      close(0);
+      if (open("/dev/null", O_RDONLY) < 0)
+         _exit(126);
+      // The watch threads block all signals, which the command would inherit
+      sigemptyset(&nosigs);
+      if ((err= posix_spawnattr_init(&attr)) == 0
+         && (err= posix_spawnattr_setsigmask(&attr, &nosigs)) == 0
+         && (err= posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK)) == 0
+      )
+         err= posix_spawnp(&gchild, argv[0], NULL, &attr, argv, environ);
+      if (err) {
+         const char *msg= strerror(err);
+         int unused= write(2, "exec: ", 6) + write(2, msg, strlen(msg)) + write(2, "\n", 1);
+         (void) unused;
+      }
+      _exit(err? 127 : 0);
+   }
+   // The intermediate has exited by the time vfork returns, so this doesn't block
+   if (waitpid(child, &status, 0) < 0)
+      perror("waitpid");
+   return status;
+}
+#endif
+
+#ifdef HAVE_SPAWN_HELPER
+// The spawn helper is a small process forked early, which starts the commands
+// of 'run' actions on behalf of this one, so that the cost of starting them
+// doesn't grow with the size of this process.  Each message on the socket is
+// one argv, as a sequence of NUL-terminated strings.
+static int   spawn_helper_fd= -1;
+static pid_t spawn_helper_pid= 0;
+
+// Main loop of the helper.  It is a fork of the perl process, but never
+// returns to perl; it exits when every process holding the other end of the
+// socket has closed it.
+static void spawn_helper_main(int sock) {
+   static char buf[65536];
+   char *argv[1024], *p, *end;
+   struct sigaction sa;
+   posix_spawnattr_t attr;
+   sigset_t nosigs, dflsigs;
+   pid_t child;
+   ssize_t len;
+   int sig, argc, err;
+   // Perl's signal handlers can't run here.  Reap the commands automatically.
+   for (sig= 1; sig < NSIG; sig++) {
+      if (sigaction(sig, NULL, &sa) == 0 && sa.sa_handler != SIG_DFL && sa.sa_handler != SIG_IGN) {
+         sa.sa_handler= SIG_DFL;
+         sa.sa_flags= 0;
+         sigaction(sig, &sa, NULL);
+      }
+   }
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler= SIG_IGN;
+   sigaction(SIGCHLD, &sa, NULL);
+   sigemptyset(&nosigs);
+   sigprocmask(SIG_SETMASK, &nosigs, NULL);
+   // Don't hold open any of the worker's files or sockets
+   close(0);
+   if (open("/dev/null", O_RDONLY) < 0)
+      _exit(126);
+   if (sock != 3) {
+      if (dup2(sock, 3) < 0)
+         _exit(126);
+      sock= 3;
+   }
+   // The commands must not inherit it, or a long-running one would keep the
+   // worker's end writable after the helper exits, and swallow its requests.
+   if (fcntl(sock, F_SETFD, FD_CLOEXEC) < 0)
+      _exit(126);
+   #ifdef SYS_close_range
+   if (syscall(SYS_close_range, 4, ~0U, 0) != 0)
+   #endif
+   {
+      struct rlimit lim;
+      int fd, max_fd= getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < 0x100000? lim.rlim_cur : 0x100000;
+      for (fd= 4; fd < max_fd; fd++)
+         close(fd);
+   }
+   // The commands get an empty signal mask and default SIGCHLD handling
+   sigemptyset(&dflsigs);
+   sigaddset(&dflsigs, SIGCHLD);
+   if ((err= posix_spawnattr_init(&attr)) != 0
+      || (err= posix_spawnattr_setsigmask(&attr, &nosigs)) != 0
+      || (err= posix_spawnattr_setsigdefault(&attr, &dflsigs)) != 0
+      || (err= posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK|POSIX_SPAWN_SETSIGDEF)) != 0
+   )
+      _exit(126);
+   while (1) {
+      if ((len= recv(sock, buf, sizeof(buf)-1, 0)) < 0 && errno == EINTR)
+         continue;
+      if (len <= 0)
+         _exit(0);
+      buf[len]= '\0';
+      for (argc= 0, p= buf, end= buf + len; p < end && argc < 1023; p += strlen(p) + 1)
+         argv[argc++]= p;
+      argv[argc]= NULL;
+      if (argc && (err= posix_spawnp(&child, argv[0], NULL, &attr, argv, environ)) != 0) {
+         const char *msg= strerror(err);
+         int unused= write(2, "exec: ", 6) + write(2, msg, strlen(msg)) + write(2, "\n", 1);
+         (void) unused;
+      }
+   }
+}
+
+// Fork the helper, if not already running.  Returns its pid.
+// May only be called by Perl's thread.
+static pid_t spawn_helper_start() {
+   int sv[2];
+   pid_t pid;
+   if (spawn_helper_fd >= 0)
+      return spawn_helper_pid;
+   if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0)
+      croak("socketpair: %s", strerror(errno));
+   if ((pid= fork()) < 0) {
+      close(sv[0]);
+      close(sv[1]);
+      croak("fork: %s", strerror(errno));
+   }
+   if (pid == 0) {
+      close(sv[0]);
+      spawn_helper_main(sv[1]);
+   }
+   close(sv[1]);
+   // commands started by 'run' or 'exec' shouldn't keep the helper alive
+   fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+   spawn_helper_pid= pid;
+   spawn_helper_fd= sv[0];
+   return pid;
+}
+
+// Ask the helper to start a command.  Returns false if there is no helper, or
+// the message couldn't be delivered right away, in which case the caller
+// starts the command itself.
+static bool spawn_helper_send(char **argv) {
+   struct iovec iov[1024];
+   struct msghdr msg;
+   size_t total= 0;
+   int i;
+   if (spawn_helper_fd < 0)
+      return false;
+   // must fit the helper's buffers
+   for (i= 0; argv[i]; i++) {
+      if (i >= 1023)
+         return false;
+      iov[i].iov_base= argv[i];
+      total += (iov[i].iov_len= strlen(argv[i]) + 1);
+   }
+   if (total >= 65536)
+      return false;
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov= iov;
+   msg.msg_iovlen= i;
+   return sendmsg(spawn_helper_fd, &msg, MSG_DONTWAIT|MSG_NOSIGNAL) > 0;
+}
+#endif
+
+#ifdef HAVE_PIDFD_SPAWN
+// Body of the 'spawn' child.  Like the vfork'd process above, it borrows this
+// process's memory until it execs, so it can only touch its own stack and fd
+// table.
+static int spawn_child_main(void *arg) {
+   char **argv= (char**) arg;
+   struct sigaction sa;
+   sigset_t nosigs;
+   const char *msg;
+   int sig, unused;
+   close(0);
+   if (open("/dev/null", O_RDONLY) < 0)
+      _exit(126);
+   // Perl's signal handlers must not run in here before the exec.  Without
+   // CLONE_SIGHAND, this doesn't change them for the parent.
+   for (sig= 1; sig < NSIG; sig++) {
+      if (sigaction(sig, NULL, &sa) == 0 && sa.sa_handler != SIG_DFL && sa.sa_handler != SIG_IGN) {
+         sa.sa_handler= SIG_DFL;
+         sa.sa_flags= 0;
+         sigaction(sig, &sa, NULL);
+      }
+   }
+   // The watch threads block all signals, which the command would inherit
+   sigemptyset(&nosigs);
+   sigprocmask(SIG_SETMASK, &nosigs, NULL);
+   execvp(argv[0], argv);
+   msg= strerror(errno);
+   unused= write(2, "exec: ", 6) + write(2, msg, strlen(msg)) + write(2, "\n", 1);
+   (void) unused;
+   _exit(127);
+}
+
+// Start a 'spawn' command as a child of this process that has no exit signal,
+// so it doesn't send SIGCHLD and isn't visible to wait() or waitpid(-1), and
+// perl's own child handling can't reap it by accident.  CLONE_PIDFD gives a
+// pidfd for the watch thread to poll, so nothing ever blocks waiting for it.
+// Kernels before 5.2 ignore the CLONE_PIDFD flag (it used to be the no-op
+// CLONE_DETACHED), so the child starts but no pidfd comes back; then this
+// executor thread waits for it instead.  Returns false if clone() rejected
+// the flags, so the caller should fall back to fork.
+static bool spawn_tracked(struct action *act) {
+   size_t stack_len= 64*1024;
+   char *stack;
+   pid_t child;
+   int pidfd= -1;
+   stack= mmap(NULL, stack_len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK, -1, 0);
+   if (stack == MAP_FAILED) {
+      perror("mmap");
+      return true;
+   }
+   // CLONE_VFORK suspends this thread until the child execs or exits, after
+   // which it no longer needs the stack.
+   child= clone(spawn_child_main, stack + stack_len, CLONE_VM|CLONE_VFORK|CLONE_PIDFD, act->act.run.argv, &pidfd);
+   munmap(stack, stack_len);
+   if (child < 0) {
+      if (errno == EINVAL)
+         return false;
+      perror("clone");
+      return true;
+   }
+   act->act.run.pid= child;
+   if (pidfd < 0) {
+      // No pidfd to poll.  Without an exit signal, waitpid needs __WALL.
+      int status, ret;
+      while ((ret= waitpid(child, &status, __WALL)) < 0 && errno == EINTR) {}
+      if (ret == child)
+         act->act.run.status= status;
+      else
+         perror("waitpid");
+      return true;
+   }
+   act->act.run.pidfd= pidfd;
+   return true;
+}
+#endif
+
+// Wait for poll flags on fd until the deadline.  Returns 1 if ready, 0 on
+// timeout, or -1 on error.
+static int poll_until(int fd, short events, struct timespec *deadline) {
+   struct timespec now_ts;
+   struct pollfd pfd;
+   long ms;
+   int ret;
+   while (1) {
+      if (clock_gettime(CLOCK_MONOTONIC, &now_ts) != 0)
+         return -1;
+      ms= (deadline->tv_sec - now_ts.tv_sec) * 1000 + (deadline->tv_nsec - now_ts.tv_nsec) / 1000000;
+      if (ms <= 0)
+         return 0;
+      pfd.fd= fd;
+      pfd.events= events;
+      pfd.revents= 0;
+      if ((ret= poll(&pfd, 1, ms)) >= 0 || errno != EINTR)
+         return ret > 0? 1 : ret;
+   }
+}
+
+// Connect to the address of a 'send' action and send its payload, all within
+// its timeout.  Afterward, the peer needs to close the connection first,
+// because closing it while the peer's reply is unread would reset the
+// connection, and might discard the payload before the peer reads it.  Rather
+// than hold up the next action (and the executor) for that, the connection is
+// left in linger_fd for the watch thread to wait on until the deadline.
+static void send_payload(struct action_send *snd) {
+   struct timespec deadline;
+   const char *pos= snd->buf, *end= snd->buf + snd->len;
+   char discard[512];
+   socklen_t errlen;
+   ssize_t ret;
+   int fd, err, ready;
+   if (clock_gettime(CLOCK_MONOTONIC, &deadline) != 0) {
+      perror("clock_gettime(CLOCK_MONOTONIC)");
+      return;
+   }
+   deadline.tv_sec += (time_t) snd->timeout;
+   deadline.tv_nsec += (long) ((snd->timeout - (time_t) snd->timeout) * 1000000000);
+   if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_nsec -= 1000000000;
+      deadline.tv_sec++;
+   }
+   if ((fd= socket(snd->addr->sa_family, SOCK_STREAM, 0)) < 0) {
+      perror("send: socket");
+      return;
+   }
+   fcntl(fd, F_SETFD, FD_CLOEXEC);
+   if (fcntl(fd, F_SETFL, O_NONBLOCK) != 0) {
+      perror("send: fcntl(O_NONBLOCK)");
+      goto done;
+   }
+   if (connect(fd, snd->addr, snd->addr_len) != 0) {
+      if (errno != EINPROGRESS) {
+         perror("send: connect");
+         goto done;
+      }
+      if ((ready= poll_until(fd, POLLOUT, &deadline)) <= 0)
+         goto timeout;
+      errlen= sizeof(err);
+      if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errlen) != 0 || err) {
+         errno= err;
+         perror("send: connect");
+         goto done;
+      }
+   }
+   while (pos < end) {
+      if ((ret= send(fd, pos, end - pos, MSG_NOSIGNAL)) >= 0)
+         pos += ret;
+      else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+         if ((ready= poll_until(fd, POLLOUT, &deadline)) <= 0)
+            goto timeout;
+      }
+      else if (errno != EINTR) {
+         perror("send");
+         goto done;
+      }
+   }
+   shutdown(fd, SHUT_WR);
+   // The peer may have answered and closed already
+   while (1) {
+      if ((ret= recv(fd, discard, sizeof(discard), 0)) == 0)
+         break; // peer closed
+      else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+         snd->linger_fd= fd;
+         snd->linger_ts= deadline;
+         return;
+      }
+      else if (ret < 0 && errno != EINTR)
+         break;
+   }
+   goto done;
+   timeout: {
+      int unused;
+      if (ready < 0)
+         perror("send: poll");
+      else
+         unused= write(2, "send: timed out\n", 16);
+      (void) unused;
+   }
+   done:
+   close(fd);
+}
+
 bool execute_action(struct action *act, bool resume, struct timespec *now_ts, struct socketalarm *parent) {
    int low= act->op & 0xF;
    int high= act->op & ~0xF;
@@ -262,7 +748,32 @@ bool execute_action(struct action *act, bool resume, struct timespec *now_ts, st
 
    switch (high) {
    case ACT_KILL:
-      if (kill(act->act.kill.pid, act->act.kill.signal) != 0)
+      if (act->op == ACT_TKILL) {
+         // tgkill fails cleanly if the thread is gone, where pthread_kill can't
+         #ifdef SYS_tgkill
+         if (syscall(SYS_tgkill, act->act.tkill.pid, act->act.tkill.tid, act->act.tkill.signal) != 0)
+            perror("tgkill");
+         #else
+         int err;
+         if ((err= pthread_kill(act->act.tkill.thread, act->act.tkill.signal)) != 0) {
+            errno= err;
+            perror("pthread_kill");
+         }
+         #endif
+      }
+      else if (act->op == ACT_SIGQUEUE) {
+         #ifdef HAVE_SIGQUEUE
+         union sigval val;
+         memset(&val, 0, sizeof(val));
+         val.sival_int= act->act.sigq.use_id? parent->id : act->act.sigq.value;
+         if (sigqueue(act->act.sigq.pid, act->act.sigq.signal, val) != 0)
+            perror("sigqueue");
+         #else
+         if (kill(act->act.sigq.pid, act->act.sigq.signal) != 0)
+            perror("kill");
+         #endif
+      }
+      else if (kill(act->act.kill.pid, act->act.kill.signal) != 0)
          perror("kill");
       return true; // move to next action
    case ACT_SLEEP: {
@@ -281,13 +792,35 @@ bool execute_action(struct action *act, bool resume, struct timespec *now_ts, st
       }
       // Else see whether we have reached that time yet
       if (now_ts->tv_sec > parent->wake_ts.tv_sec
-         || (now_ts->tv_sec == parent->wake_ts.tv_sec && now_ts->tv_nsec >= parent->wake_ts.tv_nsec))
+         || (now_ts->tv_sec == parent->wake_ts.tv_sec && now_ts->tv_nsec >= parent->wake_ts.tv_nsec)
+      ) {
+         parent->wake_ts.tv_nsec= -1; // no longer waiting
          return true; // reached end_ts
+      }
       return false; // still waiting
    }
    //case ACT_JUMP:
    //   parent->cur_action= act->act.jmp.idx - 1; // parent will ++ after we return true
    //   return true;
+   case ACT_SEND:
+      send_payload(&act->act.snd);
+      return true;
+   case ACT_WRITE: {
+      const char *pos= act->act.wr.buf, *end= pos + act->act.wr.len;
+      ssize_t ret;
+      // Retry partial writes; the bytes are usually a single message for a
+      // pipe or eventfd, which the reader expects to arrive whole.
+      while (pos < end) {
+         if ((ret= write(act->act.wr.fd, pos, end - pos)) < 0) {
+            if (errno == EINTR)
+               continue;
+            perror("write");
+            break;
+         }
+         pos += ret;
+      }
+      return true;
+   }
    case ACT_FD_x:
       switch (low) {
       case ACT_x_SHUT_R: how= SHUT_RD; if (0)
@@ -326,7 +859,38 @@ bool execute_action(struct action *act, bool resume, struct timespec *now_ts, st
    }
    case ACT_EXEC: {
       char **argv= act->act.run.argv;
-      if (act->op == ACT_RUN) {
+      sigset_t nosigs;
+      if (act->op == ACT_SPAWN) {
+         pid_t child;
+         int status;
+         #ifdef HAVE_PIDFD_SPAWN
+         if (spawn_tracked(act))
+            return true;
+         #endif
+         // Else this executor thread waits for a forked child
+         if ((child= fork()) < 0) {
+            perror("fork");
+            return true;
+         }
+         else if (child > 0) {
+            act->act.run.pid= child;
+            if (waitpid(child, &status, 0) == child)
+               act->act.run.status= status;
+            else
+               perror("waitpid");
+            return true;
+         }
+         // else we are the child now
+      }
+      else if (act->op == ACT_RUN) {
+         #ifdef HAVE_SPAWN_HELPER
+         if (spawn_helper_send(argv))
+            return true;
+         #endif
+         #ifdef HAVE_VFORK_SPAWN
+         run_detached(argv);
+         return true;
+         #else
          // double-fork, so that parent can reap child, and grandchild gets cleaned up by init()
          pid_t child, gchild;
          if ((child= fork()) < 0) {       // fork failure
@@ -345,12 +909,16 @@ bool execute_action(struct action *act, bool resume, struct timespec *now_ts, st
             _exit(gchild < 0? 1 : 0);       // immediately exit
          }
          // else we are the grandchild now
+         #endif
       }
       close(0);
       open("/dev/null", O_RDONLY);
+      // The watch threads block all signals, which the command would inherit
+      sigemptyset(&nosigs);
+      sigprocmask(SIG_SETMASK, &nosigs, NULL);
       execvp(argv[0], argv);
       perror("exec"); // if we got here, it failed.  Log the error.
-      _exit(1); // make sure we don't continue this process.
+      _exit(act->op == ACT_SPAWN? 127 : 1); // make sure we don't continue this process.
    }
    default: {
       int unused= write(2, msgbuf, snprintf(msgbuf, sizeof(msgbuf), "BUG: No such action code %d", act->op));
@@ -384,7 +952,22 @@ static void inflate_action(struct action *act, AV *dest) {
    int high= act->op & ~0xF;
    int i;
    switch (high) {
-   case ACT_KILL:  av_extend(dest, 2);
+   case ACT_KILL:
+      if (act->op == ACT_SIGQUEUE) {
+         av_extend(dest, 2);
+         av_push(dest, newSVpvs("sigqueue"));
+         av_push(dest, newSViv(act->act.sigq.signal));
+         if (!act->act.sigq.use_id)
+            av_push(dest, newSViv(act->act.sigq.value));
+         return;
+      }
+      if (act->op == ACT_TKILL) {
+         av_extend(dest, 1);
+         av_push(dest, newSVpvs("sig_thread"));
+         av_push(dest, newSViv(act->act.tkill.signal));
+         return;
+      }
+      av_extend(dest, 2);
       av_push(dest, newSVpvs("kill"));
       av_push(dest, newSViv(act->act.kill.signal));
       av_push(dest, newSViv(act->act.kill.pid));
@@ -402,8 +985,19 @@ static void inflate_action(struct action *act, AV *dest) {
       av_push(dest, newSVpv(act_fd_variant_name(low), 0));
       av_push(dest, newSVpvn((char*)act->act.nam.addr, act->act.nam.addr_len));
       return;
+   case ACT_WRITE: av_extend(dest, 2);
+      av_push(dest, newSVpvs("write"));
+      av_push(dest, newSViv(act->act.wr.fd));
+      av_push(dest, newSVpvn(act->act.wr.buf, act->act.wr.len));
+      return;
+   case ACT_SEND: av_extend(dest, 3);
+      av_push(dest, newSVpvs("send"));
+      av_push(dest, newSVpvn((char*)act->act.snd.addr, act->act.snd.addr_len));
+      av_push(dest, newSVpvn(act->act.snd.buf, act->act.snd.len));
+      av_push(dest, newSVnv(act->act.snd.timeout));
+      return;
    case ACT_EXEC: av_extend(dest, act->act.run.argc);
-      av_push(dest, newSVpv(act->op == ACT_RUN? "run":"exec", 0));
+      av_push(dest, newSVpv(act->op == ACT_RUN? "run" : act->op == ACT_SPAWN? "spawn" : "exec", 0));
       for (i= 0; i < act->act.run.argc; i++)
          av_push(dest, newSVpv(act->act.run.argv[i], 0));
       return;
@@ -416,10 +1010,24 @@ int snprint_action(char *buffer, size_t buflen, struct action *act) {
    int low= act->op & 0xF;
    int high= act->op & ~0xF;
    switch (high) {
-   case ACT_KILL:  return snprintf(buffer, buflen, "kill sig=%d pid=%d", (int)act->act.kill.signal, (int) act->act.kill.pid);
+   case ACT_KILL:
+      if (act->op == ACT_SIGQUEUE) {
+         if (act->act.sigq.use_id)
+            return snprintf(buffer, buflen, "sigqueue sig=%d pid=%d value=(alarm id)", (int)act->act.sigq.signal, (int) act->act.sigq.pid);
+         return snprintf(buffer, buflen, "sigqueue sig=%d pid=%d value=%d", (int)act->act.sigq.signal, (int) act->act.sigq.pid, act->act.sigq.value);
+      }
+      if (act->op == ACT_TKILL)
+         return snprintf(buffer, buflen, "kill sig=%d pid=%d tid=%d", (int)act->act.tkill.signal, (int) act->act.tkill.pid, (int) act->act.tkill.tid);
+      return snprintf(buffer, buflen, "kill sig=%d pid=%d", (int)act->act.kill.signal, (int) act->act.kill.pid);
    case ACT_SLEEP: return snprintf(buffer, buflen, "sleep %.3lfs", (double)act->act.slp.seconds);
    //case ACT_JUMP:  return snprintf(buffer, buflen, "goto %d", (int)act->act.jmp.idx);
    case ACT_FD_x:  return snprintf(buffer, buflen, "%s %d", act_fd_variant_description(low), act->act.fd.fd);
+   case ACT_WRITE: return snprintf(buffer, buflen, "write %d bytes to %d", (int)act->act.wr.len, act->act.wr.fd);
+   case ACT_SEND: {
+      int pos= snprintf(buffer, buflen, "send %d bytes to ", (int)act->act.snd.len);
+      pos += snprint_sockaddr(buffer+pos, buflen > pos? buflen-pos : 0, act->act.snd.addr);
+      return pos + snprintf(buffer+pos, buflen > pos? buflen-pos : 0, " within %.3lfs", act->act.snd.timeout);
+   }
    case ACT_PNAME_x:
    case ACT_SNAME_x: {
       int pos= snprintf(buffer, buflen, "%s %s ",
@@ -429,7 +1037,8 @@ int snprint_action(char *buffer, size_t buflen, struct action *act) {
       return pos + snprint_sockaddr(buffer+pos, buflen > pos? buflen-pos : 0, act->act.nam.addr);
    }
    case ACT_EXEC: {
-      int i, pos= snprintf(buffer, buflen, "%sexec(", act->op == ACT_RUN? "fork,fork," : "");
+      int i, pos= snprintf(buffer, buflen, "%sexec(",
+         act->op == ACT_RUN? "fork,fork," : act->op == ACT_SPAWN? "spawn," : "");
       for (i= 0; i < act->act.run.argc; i++) {
          pos += snprintf(buffer+pos, buflen > pos? buflen-pos : 0, "'%s',", act->act.run.argv[i]);
       }
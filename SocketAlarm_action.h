@@ -1,11 +1,16 @@
 #define ACT_KILL          0x10
+#define ACT_TKILL         0x11
+#define ACT_SIGQUEUE      0x12
 #define ACT_SLEEP         0x20
 #define ACT_JUMP          0x30
 #define ACT_EXEC          0x40
 #define ACT_RUN           0x41
+#define ACT_SPAWN         0x42
 #define ACT_FD_x          0x50
 #define ACT_PNAME_x       0x60
 #define ACT_SNAME_x       0x70
+#define ACT_WRITE         0x80
+#define ACT_SEND          0x90
 #define ACT_x_CLOSE       0x00
 #define ACT_x_SHUT_R      0x01
 #define ACT_x_SHUT_W      0x02
@@ -15,6 +20,18 @@ struct action_kill {
    pid_t pid;
    int signal;
 };
+struct action_tkill {
+   pid_t pid;
+   pid_t tid;          // kernel thread id, where tgkill is available
+   pthread_t thread;
+   int signal;
+};
+struct action_sigqueue {
+   pid_t pid;
+   int signal;
+   int value;
+   bool use_id;        // send the alarm's id instead of 'value'
+};
 struct action_fd {
    int fd;
 };
@@ -25,6 +42,26 @@ struct action_sockname {
 struct action_run {
    char **argv;   // allocated to length argc+1
    int argc;
+   // 'spawn' only: the running child, and its wait status once reaped
+   pid_t pid;
+   int pidfd;     // -1 unless the watch thread is tracking the child
+   int status;    // -1 until reaped
+};
+struct action_write {
+   int fd;
+   const char *buf; // allocated within aux_buf
+   size_t len;
+};
+struct action_send {
+   struct sockaddr *addr; // allocated within aux_buf, like 'buf'
+   socklen_t addr_len;
+   const char *buf;
+   size_t len;
+   double timeout;
+   // The connection, once the payload is sent, until the watch thread takes
+   // it to wait for the peer to close it by linger_ts.
+   int linger_fd; // -1 if none
+   struct timespec linger_ts;
 };
 struct action_sleep {
    double seconds;
@@ -37,9 +74,13 @@ struct action {
    int orig_idx; // offset in original arrayref of actions
    union {
       struct action_kill       kill;
+      struct action_tkill      tkill;
+      struct action_sigqueue   sigq;
       struct action_fd         fd;
       struct action_sockname   nam;
       struct action_run        run;
+      struct action_write      wr;
+      struct action_send       snd;
       struct action_sleep      slp;
       //struct action_jump       jmp;
    } act;
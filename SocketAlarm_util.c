@@ -274,3 +274,197 @@ bool lazy_build_now_ts(struct timespec *now_ts) {
    }
    return true;
 }
+
+// Compare two timespecs like strcmp.  An undefined timespec (tv_nsec == -1)
+// sorts after all defined ones.
+int timespec_cmp(const struct timespec *a, const struct timespec *b) {
+   if (a->tv_nsec == -1 || b->tv_nsec == -1)
+      return (a->tv_nsec == -1) - (b->tv_nsec == -1);
+   return a->tv_sec < b->tv_sec? -1 : a->tv_sec > b->tv_sec? 1
+      : a->tv_nsec < b->tv_nsec? -1 : a->tv_nsec > b->tv_nsec? 1 : 0;
+}
+
+// Return the kernel's unique identifier for the socket on 'fd', or 0 if the
+// platform doesn't have one.  Unlike inode numbers, cookies are never reused.
+uint64_t get_socket_cookie(int fd) {
+#ifdef SO_COOKIE
+   uint64_t cookie= 0;
+   socklen_t len= sizeof(cookie);
+   if (getsockopt(fd, SOL_SOCKET, SO_COOKIE, &cookie, &len) == 0 && len == sizeof(cookie))
+      return cookie;
+#endif
+   return 0;
+}
+
+// Return 1 if the peer of a TCP socket has sent FIN (or the connection is
+// gone), 0 if not, or -1 if it can't be determined, such as for non-TCP
+// sockets or platforms without TCP_INFO.
+int get_tcp_peer_shut(int fd) {
+#if defined(__linux__) && defined(TCP_INFO)
+   struct tcp_info info;
+   socklen_t len= sizeof(info);
+   if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0 || len < 1)
+      return -1;
+   switch (info.tcpi_state) {
+   case TCP_CLOSE_WAIT: case TCP_LAST_ACK: case TCP_CLOSING:
+   case TCP_TIME_WAIT: case TCP_CLOSE:
+      return 1;
+   default:
+      return 0;
+   }
+#else
+   return -1;
+#endif
+}
+
+#ifdef HAVE_SIGQUEUE
+// Values that arrived with signals sent by sigqueue(), captured by a handler
+// that runs ahead of perl's, since perl doesn't pass si_value to %SIG
+// handlers.  The handler only appends, and Perl's thread only removes, so the
+// ring needs no lock.
+#define SIGQUEUE_RING_SIZE 64
+struct sigqueue_ring {
+   struct sigaction chained; // handler that was installed before ours
+   unsigned head, tail, dropped;
+   int values[SIGQUEUE_RING_SIZE];
+};
+static struct sigqueue_ring *sigqueue_rings[NSIG];
+
+static void sigqueue_capture_handler(int sig, siginfo_t *info, void *context) {
+   struct sigqueue_ring *ring= sig > 0 && sig < NSIG? sigqueue_rings[sig] : NULL;
+   if (!ring)
+      return;
+   if (info && info->si_code == SI_QUEUE) {
+      unsigned head= ring->head;
+      if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) < SIGQUEUE_RING_SIZE) {
+         ring->values[head % SIGQUEUE_RING_SIZE]= info->si_value.sival_int;
+         __atomic_store_n(&ring->head, head+1, __ATOMIC_RELEASE);
+      }
+      else
+         ring->dropped++;
+   }
+   if (ring->chained.sa_flags & SA_SIGINFO)
+      ring->chained.sa_sigaction(sig, info, context);
+   else if (ring->chained.sa_handler != SIG_DFL && ring->chained.sa_handler != SIG_IGN)
+      ring->chained.sa_handler(sig);
+}
+
+// Install the capturing handler in front of the current handler of 'sig'.
+// May only be called by Perl's thread.
+void sigqueue_capture(int sig) {
+   struct sigaction sa;
+   struct sigqueue_ring *ring;
+   if (sig <= 0 || sig >= NSIG)
+      croak("Invalid signal number %d", sig);
+   if (sigaction(sig, NULL, &sa) != 0)
+      croak("sigaction: %s", strerror(errno));
+   // already captured, and perl hasn't replaced the handler since
+   if ((sa.sa_flags & SA_SIGINFO) && sa.sa_sigaction == sigqueue_capture_handler)
+      return;
+   if (!(ring= sigqueue_rings[sig]))
+      Newxz(ring, 1, struct sigqueue_ring);
+   ring->chained= sa;
+   sigqueue_rings[sig]= ring;
+   sa.sa_sigaction= sigqueue_capture_handler;
+   sa.sa_flags |= SA_SIGINFO;
+   if (sigaction(sig, &sa, NULL) != 0)
+      croak("sigaction: %s", strerror(errno));
+}
+
+// Remove up to 'max' captured values for 'sig', oldest first.  Returns the
+// number of values.  May only be called by Perl's thread.
+int sigqueue_take(int sig, int *values, int max) {
+   struct sigqueue_ring *ring= sig > 0 && sig < NSIG? sigqueue_rings[sig] : NULL;
+   unsigned tail, head;
+   int n= 0;
+   if (!ring)
+      return 0;
+   tail= ring->tail;
+   head= __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+   while (tail != head && n < max)
+      values[n++]= ring->values[tail++ % SIGQUEUE_RING_SIZE];
+   __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+   return n;
+}
+#endif
+
+// Free lists of blocks in power-of-two size classes, for structs that are
+// created and destroyed at request rate (struct socketalarm), so that a busy
+// process reuses the same few blocks instead of churning the allocator.  Only
+// Perl's thread allocates and frees alarms (the watch and executor threads
+// never do), but each interpreter thread does so for its own, so the free
+// lists are process-global and locked.  The blocks come from malloc rather
+// than Perl's allocator, since a block may serve several interpreters in turn.
+#define BLOCK_POOL_MIN_SHIFT 7    // 128 bytes
+#define BLOCK_POOL_CLASSES   6    // up to 4096 bytes
+#define BLOCK_POOL_MAX_FREE  1024 // per size class
+struct block_pool_stats {
+   size_t hits;     // allocations served from a free list
+   size_t misses;   // allocations that called malloc
+   size_t released; // frees that went back to malloc, because the list was full or the block too big
+   size_t cached;   // blocks currently on the free lists
+};
+static pthread_mutex_t block_pool_mutex= PTHREAD_MUTEX_INITIALIZER;
+static void *block_pool_free_list[BLOCK_POOL_CLASSES];
+static size_t block_pool_free_count[BLOCK_POOL_CLASSES];
+static struct block_pool_stats block_pool_stats;
+
+// Size class for a block of 'size' bytes, or -1 if too big to be pooled.
+static int block_pool_class(size_t size) {
+   int cls= 0;
+   while (((size_t)1 << (cls + BLOCK_POOL_MIN_SHIFT)) < size)
+      if (++cls >= BLOCK_POOL_CLASSES)
+         return -1;
+   return cls;
+}
+
+// Return a zero-filled block of at least 'size' bytes, or NULL if out of memory.
+void *block_pool_alloc(size_t size) {
+   int cls= block_pool_class(size);
+   void *block= NULL;
+   if (cls >= 0) {
+      pthread_mutex_lock(&block_pool_mutex);
+      if ((block= block_pool_free_list[cls])) {
+         block_pool_free_list[cls]= *(void**) block;
+         --block_pool_free_count[cls];
+         --block_pool_stats.cached;
+         ++block_pool_stats.hits;
+      }
+      else
+         ++block_pool_stats.misses;
+      pthread_mutex_unlock(&block_pool_mutex);
+      if (block)
+         return memset(block, 0, (size_t)1 << (cls + BLOCK_POOL_MIN_SHIFT));
+      size= (size_t)1 << (cls + BLOCK_POOL_MIN_SHIFT);
+   }
+   else {
+      pthread_mutex_lock(&block_pool_mutex);
+      ++block_pool_stats.misses;
+      pthread_mutex_unlock(&block_pool_mutex);
+   }
+   return calloc(1, size);
+}
+
+// Return a block from block_pool_alloc, which must be given the same 'size'.
+void block_pool_free(void *block, size_t size) {
+   int cls= block_pool_class(size);
+   pthread_mutex_lock(&block_pool_mutex);
+   if (cls >= 0 && block_pool_free_count[cls] < BLOCK_POOL_MAX_FREE) {
+      *(void**) block= block_pool_free_list[cls];
+      block_pool_free_list[cls]= block;
+      ++block_pool_free_count[cls];
+      ++block_pool_stats.cached;
+      block= NULL;
+   }
+   else
+      ++block_pool_stats.released;
+   pthread_mutex_unlock(&block_pool_mutex);
+   if (block)
+      free(block);
+}
+
+void block_pool_get_stats(struct block_pool_stats *out) {
+   pthread_mutex_lock(&block_pool_mutex);
+   *out= block_pool_stats;
+   pthread_mutex_unlock(&block_pool_mutex);
+}
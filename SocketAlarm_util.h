@@ -2,4 +2,15 @@ static int parse_signal(SV *name);
 static int fileno_from_sv(SV *sv);
 static int snprint_sockaddr(char *buffer, size_t buflen, struct sockaddr *addr);
 static int snprint_fd_table(char *buf, size_t sizeof_buf, int max_fd);
-static bool lazy_build_now_ts(struct timespec *now_ts);
\ No newline at end of file
+static bool lazy_build_now_ts(struct timespec *now_ts);
+static int timespec_cmp(const struct timespec *a, const struct timespec *b);
+static uint64_t get_socket_cookie(int fd);
+static int get_tcp_peer_shut(int fd);
+struct block_pool_stats;
+static void *block_pool_alloc(size_t size);
+static void block_pool_free(void *block, size_t size);
+static void block_pool_get_stats(struct block_pool_stats *out);
+#ifdef HAVE_SIGQUEUE
+static void sigqueue_capture(int sig);
+static int sigqueue_take(int sig, int *values, int max);
+#endif
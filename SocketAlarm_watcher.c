@@ -1,5 +1,3 @@
-#include "pollfd_rbhash.c"
-
 // Returns false when time to exit
 static bool do_watch();
 
@@ -15,220 +13,1017 @@ void watch_thread_log(void* buffer, int len) {
 #define WATCHTHREAD_WARN(fmt, ...) ((void)0)
 #endif
 
-void* watch_thread_main(void* unused) {
-   while (do_watch()) {}
-   return NULL;
+// Poll flags that the socketalarm needs from the kernel in its current state.
+// Alarms that have triggered (or finished) don't need to watch anything.
+static short socketalarm_poll_events(struct socketalarm *alarm) {
+   short events= 0;
+   int mask= alarm->event_mask;
+   if (alarm->cur_action != -1)
+      return 0;
+   #ifdef POLLRDHUP
+   if (mask & EVENT_SHUT)
+      events |= POLLRDHUP;
+   #endif
+   // If a fd gets data in the queue, there is no way to wait exclusively
+   // for the EOF event, so don't ask for POLLIN in the "unwaitable" state.
+   if ((mask & EVENT_EOF) && !alarm->unwaitable)
+      events |= POLLIN;
+   #ifdef POLLRDHUP
+   // But EOF can't happen until the peer shuts down its side, which can be
+   // waited for.  After that, it depends on when the application reads.
+   else if ((mask & EVENT_EOF) && !alarm->peer_shut)
+      events |= POLLRDHUP;
+   #endif
+   if (mask & EVENT_IN)
+      events |= POLLIN;
+   if (mask & EVENT_PRI)
+      events |= POLLPRI;
+   return events;
 }
 
-// separate from watch_thread_main because it uses a dynamic alloca() on each iteration
-bool do_watch() {
-   struct pollfd *pollset;
-   struct timespec wake_time= { 0, -1 };
-   int capacity, buckets, sz, n_poll, i, j, n, delay= 10000;
-   char msgbuf[128];
-   
-   if (pthread_mutex_lock(&watch_list_mutex))
-      abort(); // should never fail
-   // allocate to the size of watch_list_count, but cap it at 1024 for sanity
-   // since this is coming off the stack.  If any user actually wants to watch
-   // more than 1024 sockets, this needs re-designed, but I'm not sure if
-   // malloc is thread-safe when the main perl binary was compiled without
-   // thread support.
-   capacity= watch_list_count > 1024? 1024 : watch_list_count+1;
-   buckets= capacity < 16? 16 : capacity < 128? 32 : 64;
-   sz= sizeof(struct pollfd) * capacity + POLLFD_RBHASH_SIZEOF(capacity, buckets);
-   pollset= (struct pollfd *) alloca(sz);
-   memset(pollset, 0, sz);
-   
-   // first fd is always our control socket
-   pollset[0].fd= control_pipe[0];
-   pollset[0].events= POLLIN;
-   n_poll= 1;
-   WATCHTHREAD_DEBUG("watch_thread loop iter, watch_list_count=%d capacity=%d buckets=%d\n", watch_list_count, capacity, buckets);
-   for (i= 0, n= watch_list_count; i < n && n_poll < capacity; i++) {
-      struct socketalarm *alarm= watch_list[i];
-      int fd= alarm->watch_fd;
-      // Ignore watches that finished.  Main thread needs to clean these up.
-      if (alarm->cur_action >= alarm->action_count)
-         continue;
-      // If the socketalarm is in the process of being executed and stopped at
-      // a 'sleep' command, factor that into the wake time.
-      if (alarm->wake_ts.tv_nsec != -1) {
-         if (wake_time.tv_nsec == -1
-          || wake_time.tv_sec > alarm->wake_ts.tv_sec
-          || (wake_time.tv_sec == alarm->wake_ts.tv_sec && wake_time.tv_nsec > alarm->wake_ts.tv_nsec)
-         ) {
-            wake_time.tv_sec= alarm->wake_ts.tv_sec;
-            wake_time.tv_nsec= alarm->wake_ts.tv_nsec;
+// Grow a buffer that belongs to the watch thread so that it holds at least
+// 'needed' elements.  This uses mmap instead of malloc, because malloc isn't
+// necessarily thread-safe when the main perl binary was compiled without
+// thread support.  Existing contents are preserved.
+static bool watch_buf_grow(void **buf, size_t *alloc, size_t elem_size, size_t needed) {
+   size_t page= sysconf(_SC_PAGESIZE), old_len= *alloc * elem_size, new_len;
+   void *newbuf;
+   if (needed <= *alloc)
+      return true;
+   new_len= old_len? old_len : page;
+   while (new_len < needed * elem_size)
+      new_len *= 2;
+   #ifdef MREMAP_MAYMOVE
+   if (*buf)
+      newbuf= mremap(*buf, old_len, new_len, MREMAP_MAYMOVE);
+   else
+   #endif
+   {
+      newbuf= mmap(NULL, new_len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+      if (newbuf != MAP_FAILED && *buf) {
+         memcpy(newbuf, *buf, old_len);
+         munmap(*buf, old_len);
+      }
+   }
+   if (newbuf == MAP_FAILED)
+      return false;
+   *buf= newbuf;
+   *alloc= new_len / elem_size;
+   return true;
+}
+
+// Make the pollset slot of 'fd' agree with its entry in the fd table.  An fd
+// only occupies a slot while some alarm needs poll flags for it.  Holes are
+// filled by moving the final slot, so the pollset stays dense.
+// Only called by the watch thread, holding watch_list_mutex.
+static bool watch_pollset_update(int fd) {
+   struct watch_fd *wfd= watch_fds + fd;
+   int slot= wfd->poll_slot, last;
+   bool present= slot > 0 && slot < watch_pollset_count && watch_pollset[slot].fd == fd;
+   if (wfd->events) {
+      if (!present) {
+         if (!watch_buf_grow((void**) &watch_pollset, &watch_pollset_alloc, sizeof(struct pollfd), watch_pollset_count+1))
+            return false;
+         slot= wfd->poll_slot= watch_pollset_count++;
+         watch_pollset[slot].fd= fd;
+         watch_pollset[slot].revents= 0;
+      }
+      watch_pollset[slot].events= wfd->events;
+   }
+   else if (present) {
+      last= --watch_pollset_count;
+      if (slot < last) {
+         watch_pollset[slot]= watch_pollset[last];
+         watch_fds[watch_pollset[slot].fd].poll_slot= slot;
+      }
+      wfd->poll_slot= 0;
+   }
+   return true;
+}
+
+// The timer heap is a binary min-heap of the alarms that have a deadline,
+// so the next deadline is always watch_timers[0].  Each alarm knows its
+// position in timer_idx, so it can be removed or re-positioned in O(log n).
+// Must hold watch_list_mutex.
+//
+// A waiting alarm's deadline is its next recheck, and a triggered alarm's
+// deadline is the end of the 'sleep' action it is paused at.
+static struct timespec *watch_timer_ts(struct socketalarm *alarm) {
+   return alarm->cur_action == -1? &alarm->recheck_ts : &alarm->wake_ts;
+}
+
+static void watch_timer_place(struct socketalarm *alarm, int idx) {
+   watch_timers[idx]= alarm;
+   alarm->timer_idx= idx;
+}
+
+static void watch_timer_sift(int idx) {
+   struct socketalarm *alarm= watch_timers[idx];
+   struct timespec *ts= watch_timer_ts(alarm);
+   int parent, child;
+   // move up while earlier than parent
+   while (idx > 0 && timespec_cmp(ts, watch_timer_ts(watch_timers[parent= (idx-1)/2])) < 0) {
+      watch_timer_place(watch_timers[parent], idx);
+      idx= parent;
+   }
+   // move down while later than the earliest child
+   while ((child= idx*2+1) < watch_timer_count) {
+      if (child+1 < watch_timer_count
+         && timespec_cmp(watch_timer_ts(watch_timers[child+1]), watch_timer_ts(watch_timers[child])) < 0)
+         ++child;
+      if (timespec_cmp(watch_timer_ts(watch_timers[child]), ts) >= 0)
+         break;
+      watch_timer_place(watch_timers[child], idx);
+      idx= child;
+   }
+   watch_timer_place(alarm, idx);
+}
+
+// Remove alarm from the timer heap, if present.
+static void watch_timer_remove(struct socketalarm *alarm) {
+   int idx= alarm->timer_idx;
+   if (idx < 0)
+      return;
+   alarm->timer_idx= -1;
+   if (idx < --watch_timer_count) {
+      watch_timer_place(watch_timers[watch_timer_count], idx);
+      watch_timer_sift(idx);
+   }
+}
+
+// Add, move, or remove the alarm in the timer heap according to its deadline.
+static bool watch_timer_update(struct socketalarm *alarm) {
+   if (watch_timer_ts(alarm)->tv_nsec == -1 || alarm->cur_action >= alarm->action_count)
+      watch_timer_remove(alarm);
+   else if (alarm->timer_idx >= 0)
+      watch_timer_sift(alarm->timer_idx);
+   else {
+      if (!watch_buf_grow((void**) &watch_timers, &watch_timers_alloc, sizeof(*watch_timers), watch_timer_count+1))
+         return false;
+      watch_timer_place(alarm, watch_timer_count++);
+      watch_timer_sift(alarm->timer_idx);
+   }
+   return true;
+}
+
+// Whether the alarm's condition can't be waited on with poll flags, and needs
+// to be checked periodically: EVENT_CLOSE, or EVENT_EOF with unread data in
+// the socket after the peer shut down its side.  (or with no way to wait
+// for the peer's shutdown)
+static bool socketalarm_needs_recheck(struct socketalarm *alarm) {
+   if (alarm->event_mask & EVENT_CLOSE)
+      return true;
+   #ifdef POLLRDHUP
+   return (alarm->event_mask & EVENT_EOF) && alarm->unwaitable && alarm->peer_shut;
+   #else
+   return (alarm->event_mask & EVENT_EOF) && alarm->unwaitable;
+   #endif
+}
+
+// Set the time of the next recheck for an alarm that needs it.  The interval starts at watch_recheck_min and doubles each
+// time, up to watch_recheck_max, until 'reset' (the alarm's state changed).
+// Clears recheck_ts if the alarm doesn't need rechecks.  The caller then needs
+// to watch_timer_update.  Must hold watch_list_mutex.
+static void watch_recheck_schedule(struct socketalarm *alarm, bool reset) {
+   struct timespec now_ts= { 0, -1 };
+   double t;
+   if (alarm->cur_action != -1
+      || !socketalarm_needs_recheck(alarm)
+      || !lazy_build_now_ts(&now_ts)
+   ) {
+      alarm->recheck_ts.tv_nsec= -1;
+      alarm->recheck_interval= 0;
+      return;
+   }
+   if (reset || alarm->recheck_interval <= 0)
+      alarm->recheck_interval= watch_recheck_min;
+   else if ((alarm->recheck_interval *= 2) > watch_recheck_max)
+      alarm->recheck_interval= watch_recheck_max;
+   t= alarm->recheck_interval;
+   alarm->recheck_ts.tv_sec= now_ts.tv_sec + (time_t) t;
+   alarm->recheck_ts.tv_nsec= now_ts.tv_nsec + (long) ((t - (time_t) t) * 1000000000);
+   if (alarm->recheck_ts.tv_nsec >= 1000000000) {
+      alarm->recheck_ts.tv_nsec -= 1000000000;
+      alarm->recheck_ts.tv_sec++;
+   }
+}
+
+// epoll event data of a registered fd, and the generation of the registration.
+// The control fd and timerfd use generation 0.
+#define WATCH_EPOLL_DATA(fd, gen) (((uint64_t)(gen) << 32) | (uint32_t)(fd))
+#define WATCH_EPOLL_FD(data)      ((int)(uint32_t)(data))
+#define WATCH_EPOLL_GEN(data)     ((uint32_t)((data) >> 32))
+
+// Recompute the combined poll flags of all alarms on 'fd', and if using epoll,
+// update the kernel's interest set to match.  For poll, the pollset belongs to
+// the watch thread, so other threads queue the fd for the watch thread to
+// update, and wake it.  Must hold watch_list_mutex.
+static void watch_fd_sync(int fd) {
+   struct watch_fd *wfd= watch_fds + fd;
+   struct socketalarm *alarm;
+   short events= wfd->spawn_pid || wfd->linger? POLLIN : 0;
+   for (alarm= wfd->alarms; alarm; alarm= alarm->fd_next)
+      events |= socketalarm_poll_events(alarm);
+   wfd->events= events;
+   #ifdef HAVE_EPOLL
+   if (watch_backend == WATCH_BACKEND_EPOLL && epoll_fd >= 0) {
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      // poll and epoll flags have the same values on Linux.  Registrations
+      // are one-shot, and re-armed after the watch thread handles them,
+      // because one whose fd the user closed can't be deleted while the file
+      // is still open elsewhere (a dup, or a child process), and would
+      // otherwise keep firing.  Its events carry a generation number, so
+      // that they aren't mistaken for a newer socket with the same number.
+      ev.events= events | EPOLLONESHOT;
+      if (!events) {
+         // ENOENT or EBADF just mean the kernel already forgot the fd because
+         // the user closed it.
+         if (wfd->registered)
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+         wfd->registered= false;
+      }
+      else if (wfd->registered) {
+         ev.data.u64= WATCH_EPOLL_DATA(fd, wfd->epoll_gen);
+         // If the fd was closed and reused, this is a different file.
+         if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) != 0 && errno == ENOENT) {
+            ev.data.u64= WATCH_EPOLL_DATA(fd, ++wfd->epoll_gen);
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
          }
       }
       else {
-         // Find a pollset slot for this file descriptor, collapsing duplicates.
-         // The next unused one is at [n_poll], which has NodeID n_poll+1
-         int poll_i= -1 + (int)pollfd_rbhash_insert(pollset+capacity, capacity, n_poll+1, fd & (buckets-1), fd);
-         if (poll_i < 0) { // corrupt datastruct, should never happen
-            WATCHTHREAD_WARN("BUG: corrupt pollfd_rbhash");
+         ev.data.u64= WATCH_EPOLL_DATA(fd, ++wfd->epoll_gen);
+         // EEXIST can happen if the user closed the fd and a new socket was
+         // opened with the same number that the kernel still remembers.
+         if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0 && errno == EEXIST)
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+         wfd->registered= true;
+      }
+   }
+   #endif
+   if (watch_backend == WATCH_BACKEND_POLL) {
+      if (control_pipe[1] >= 0 && pthread_equal(pthread_self(), watch_thread)) {
+         if (!watch_pollset_update(fd))
+            perror("mmap");
+      }
+      else if (!wfd->change_queued) {
+         if (!watch_buf_grow((void**) &watch_fd_changes, &watch_fd_changes_alloc, sizeof(int), watch_fd_changes_count+1))
+            perror("mmap");
+         else {
+            watch_fd_changes[watch_fd_changes_count++]= fd;
+            wfd->change_queued= true;
+         }
+      }
+   }
+}
+
+// Add alarm to the list of alarms for its fd.  Must hold watch_list_mutex.
+static bool watch_fd_link(struct socketalarm *alarm) {
+   int fd= alarm->watch_fd;
+   // new pages of the mapping are zero-filled
+   if (!watch_buf_grow((void**) &watch_fds, &watch_fds_alloc, sizeof(struct watch_fd), fd+1))
+      return false;
+   alarm->fd_next= watch_fds[fd].alarms;
+   watch_fds[fd].alarms= alarm;
+   watch_fd_sync(fd);
+   return true;
+}
+
+// Remove alarm from the list of alarms for its fd.  Must hold watch_list_mutex.
+static void watch_fd_unlink(struct socketalarm *alarm) {
+   int fd= alarm->watch_fd;
+   struct socketalarm **ref;
+   if (fd < watch_fds_alloc) {
+      for (ref= &watch_fds[fd].alarms; *ref; ref= &(*ref)->fd_next) {
+         if (*ref == alarm) {
+            *ref= alarm->fd_next;
             break;
          }
-         if (poll_i == n_poll) { // using the new uninitialized one?
-            pollset[poll_i].fd= fd;
-            pollset[poll_i].events= 0;
-            ++n_poll;
+      }
+      watch_fd_sync(fd);
+   }
+   alarm->fd_next= NULL;
+}
+
+// Remove completed watches from the list, except those that an executor
+// still holds.  Must hold watch_list_mutex.
+static void watch_list_cleanup() {
+   int i;
+   for (i= watch_list_count-1; i >= 0; --i) {
+      if (watch_list[i]->cur_action >= watch_list[i]->action_count && !watch_list[i]->executing) {
+         watch_list[i]->list_ofs= -1;
+         watch_fd_unlink(watch_list[i]);
+         watch_timer_remove(watch_list[i]);
+         if (--watch_list_count > i) {
+            watch_list[i]= watch_list[watch_list_count];
+            watch_list[i]->list_ofs= i;
          }
-         // Add the poll flags of this socketalarm
-         int events= alarm->event_mask;
+         watch_list[watch_list_count]= NULL;
+      }
+   }
+}
+
+// Start watching the pidfds of the children that the alarm's 'spawn' actions
+// just started.  Must hold watch_list_mutex.
+static void watch_spawn_track(struct socketalarm *alarm) {
+   bool added= false;
+   int i, fd;
+   for (i= 0; i < alarm->action_count; i++) {
+      struct action *act= alarm->actions + i;
+      if (act->op != ACT_SPAWN || (fd= act->act.run.pidfd) < 0)
+         continue;
+      if (!watch_buf_grow((void**) &watch_fds, &watch_fds_alloc, sizeof(struct watch_fd), fd+1)) {
+         perror("mmap");
+         continue;
+      }
+      if (watch_fds[fd].spawn == act)
+         continue; // from a previous run of the actions
+      watch_fds[fd].spawn= act;
+      watch_fds[fd].spawn_pid= act->act.run.pid;
+      watch_fd_sync(fd);
+      added= true;
+   }
+   if (added && !watch_thread_wake())
+      perror("write(control_pipe)");
+}
+
+// The pidfd of a 'spawn' child became readable, which means it exited.  Reap
+// it, record the status if the alarm still exists, and close the pidfd.
+// Must hold watch_list_mutex.
+static void watch_spawn_reap(int fd) {
+   struct watch_fd *wfd= watch_fds + fd;
+   int status= -1;
+   pid_t ret= waitpid(wfd->spawn_pid, &status, WNOHANG|__WALL);
+   if (ret == 0)
+      return; // still running
+   if (ret < 0) {
+      perror("waitpid");
+      status= -1;
+   }
+   if (wfd->spawn) {
+      wfd->spawn->act.run.status= status;
+      wfd->spawn->act.run.pidfd= -1;
+   }
+   wfd->spawn= NULL;
+   wfd->spawn_pid= 0;
+   watch_fd_sync(fd);
+   close(fd);
+}
+
+// Take over the connections of the alarm's 'send' actions that are waiting
+// for their peer to close them.  Must hold watch_list_mutex.
+static void watch_send_linger(struct socketalarm *alarm) {
+   bool added= false;
+   int i, fd;
+   for (i= 0; i < alarm->action_count; i++) {
+      struct action *act= alarm->actions + i;
+      if (act->op != ACT_SEND || (fd= act->act.snd.linger_fd) < 0)
+         continue;
+      act->act.snd.linger_fd= -1;
+      if (!watch_buf_grow((void**) &watch_fds, &watch_fds_alloc, sizeof(struct watch_fd), fd+1)
+         || !watch_buf_grow((void**) &watch_lingers, &watch_lingers_alloc, sizeof(int), watch_linger_count+1)
+      ) {
+         perror("mmap");
+         close(fd);
+         continue;
+      }
+      watch_fds[fd].linger= true;
+      watch_fds[fd].linger_ts= act->act.snd.linger_ts;
+      watch_lingers[watch_linger_count++]= fd;
+      watch_fd_sync(fd);
+      added= true;
+   }
+   if (added && !watch_thread_wake())
+      perror("write(control_pipe)");
+}
+
+// Stop waiting on a 'send' connection, and close it.  Must hold watch_list_mutex.
+static void watch_linger_end(int fd) {
+   int i;
+   for (i= 0; i < watch_linger_count; i++) {
+      if (watch_lingers[i] == fd) {
+         watch_lingers[i]= watch_lingers[--watch_linger_count];
+         break;
+      }
+   }
+   watch_fds[fd].linger= false;
+   watch_fd_sync(fd);
+   close(fd);
+}
+
+// A 'send' connection became readable.  Discard whatever the peer replied,
+// and close it once the peer closed its side.  Must hold watch_list_mutex.
+static void watch_linger_read(int fd) {
+   char discard[512];
+   ssize_t ret;
+   int n;
+   // Don't let a chatty peer hold up the other fds; it gets another turn.
+   for (n= 0; n < 16; n++) {
+      if ((ret= recv(fd, discard, sizeof(discard), MSG_DONTWAIT)) == 0)
+         break; // peer closed
+      else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+         return;
+      else if (ret < 0 && errno != EINTR)
+         break;
+   }
+   if (n < 16)
+      watch_linger_end(fd);
+}
+
+// Make the notify fd readable, unless it already is.  Must hold watch_list_mutex.
+static void watch_notify() {
+   if (watch_notify_fd[1] >= 0 && !watch_notify_pending) {
+      #ifdef HAVE_EVENTFD
+      uint64_t n= 1;
+      if (write(watch_notify_fd[1], &n, sizeof(n)) != sizeof(n))
+      #else
+      if (write(watch_notify_fd[1], "n", 1) != 1)
+      #endif
+         perror("write(notify_fd)");
+      else
+         watch_notify_pending= true;
+   }
+}
+
+// Append a newly triggered alarm to the queue for drain_triggered.
+// Must hold watch_list_mutex.
+static void watch_fired_push(struct socketalarm *alarm) {
+   if (alarm->fired_queued)
+      return;
+   alarm->fired_queued= true;
+   alarm->fired_next= NULL;
+   if (watch_fired_tail)
+      watch_fired_tail->fired_next= alarm;
+   else
+      watch_fired_head= alarm;
+   watch_fired_tail= alarm;
+   watch_notify();
+}
+
+// Remove an alarm from the queue for drain_triggered.  Must hold watch_list_mutex.
+static void watch_fired_unlink(struct socketalarm *alarm) {
+   struct socketalarm **ref= &watch_fired_head, *prev= NULL;
+   if (!alarm->fired_queued)
+      return;
+   for (; *ref; prev= *ref, ref= &(*ref)->fired_next) {
+      if (*ref == alarm) {
+         *ref= alarm->fired_next;
+         if (watch_fired_tail == alarm)
+            watch_fired_tail= prev;
+         break;
+      }
+   }
+   alarm->fired_queued= false;
+}
+
+static void* watch_executor_main(void *unused);
+
+// Hand a triggered alarm (or one whose 'sleep' expired) to an executor thread,
+// starting another executor if all are busy.  Must hold watch_list_mutex.
+static void watch_exec_enqueue(struct socketalarm *alarm) {
+   int queued= 0;
+   struct socketalarm *cur;
+   if (alarm->cur_action < 0) {
+      socketalarm_cur_action_set(alarm, 0); // it is triggered from now on
+      watch_fired_push(alarm);
+   }
+   alarm->executing= true;
+   alarm->exec_next= NULL;
+   if (watch_exec_tail)
+      watch_exec_tail->exec_next= alarm;
+   else
+      watch_exec_head= alarm;
+   watch_exec_tail= alarm;
+   for (cur= watch_exec_head; cur && queued <= watch_executor_idle; cur= cur->exec_next)
+      ++queued;
+   if (queued > watch_executor_idle && watch_executor_count < WATCH_EXECUTOR_MAX) {
+      pthread_t thread;
+      pthread_attr_t attr;
+      // The new thread inherits the watch thread's blocked signals
+      if (pthread_attr_init(&attr) == 0) {
+         pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+         if (pthread_create(&thread, &attr, watch_executor_main, NULL) == 0)
+            ++watch_executor_count;
+         else
+            perror("pthread_create");
+         pthread_attr_destroy(&attr);
+      }
+   }
+   if (watch_executor_count)
+      pthread_cond_signal(&watch_exec_ready);
+   else {
+      // Can't start any executor, so run it here like in the old days
+      watch_exec_head= watch_exec_tail= NULL;
+      socketalarm_exec_actions(alarm);
+      watch_spawn_track(alarm);
+      watch_send_linger(alarm);
+      alarm->executing= false;
+      if (!watch_timer_update(alarm))
+         perror("mmap");
+   }
+}
+
+// Remove an alarm from the executor queue if no executor claimed it yet.
+// Must hold watch_list_mutex.
+static bool watch_exec_dequeue(struct socketalarm *alarm) {
+   struct socketalarm **ref= &watch_exec_head, *prev= NULL;
+   for (; *ref; prev= *ref, ref= &(*ref)->exec_next) {
+      if (*ref == alarm) {
+         *ref= alarm->exec_next;
+         if (watch_exec_tail == alarm)
+            watch_exec_tail= prev;
+         alarm->executing= false;
+         return true;
+      }
+   }
+   return false;
+}
+
+// Executor threads take alarms from the queue and run their actions without
+// holding watch_list_mutex, so that a slow action (like 'run' waiting for its
+// child) doesn't block Perl's thread or the other alarms.  The alarm can't be
+// freed while 'executing' is set.
+static void* watch_executor_main(void *unused) {
+   struct socketalarm *alarm;
+   if (pthread_mutex_lock(&watch_list_mutex))
+      abort(); // should never fail
+   while (!watch_terminating) {
+      if (!(alarm= watch_exec_head)) {
+         ++watch_executor_idle;
+         pthread_cond_wait(&watch_exec_ready, &watch_list_mutex);
+         --watch_executor_idle;
+         continue;
+      }
+      if (!(watch_exec_head= alarm->exec_next))
+         watch_exec_tail= NULL;
+      pthread_mutex_unlock(&watch_list_mutex);
+
+      socketalarm_exec_actions(alarm);
+
+      if (pthread_mutex_lock(&watch_list_mutex))
+         abort(); // should never fail
+      watch_spawn_track(alarm);
+      watch_send_linger(alarm);
+      alarm->executing= false;
+      // If it stopped at a 'sleep', the watch thread needs to wake for it,
+      // unless the alarm was cancelled meanwhile.
+      if (alarm->list_ofs >= 0 && alarm->wake_ts.tv_nsec != -1) {
+         if (!watch_timer_update(alarm))
+            perror("mmap");
+         else if (alarm->timer_idx == 0)
+            watch_thread_wake();
+      }
+      pthread_cond_broadcast(&watch_exec_done);
+   }
+   --watch_executor_count;
+   pthread_mutex_unlock(&watch_list_mutex);
+   return NULL;
+}
+
+// Is the alarm's fd still the socket it was created for?  (or has it been
+// closed, and possibly the number reused)  The socket cookie is checked with
+// one getsockopt and is never reused, else fall back to device and inode.
+static bool socketalarm_fd_is_same(struct socketalarm *alarm) {
+   struct stat statbuf;
+   if (alarm->watch_fd_cookie)
+      return get_socket_cookie(alarm->watch_fd) == alarm->watch_fd_cookie;
+   return fstat(alarm->watch_fd, &statbuf) == 0
+      && statbuf.st_dev == alarm->watch_fd_dev
+      && statbuf.st_ino == alarm->watch_fd_ino;
+}
+
+// Decide whether an untriggered alarm should trigger, given the poll flags
+// for its fd (if any), and run its actions if so.  Otherwise, schedule its
+// next recheck.  Must hold watch_list_mutex.
+static void watch_alarm_check(struct socketalarm *alarm, int revents) {
+   bool trigger= false, was_unwaitable= alarm->unwaitable, was_peer_shut= alarm->peer_shut;
+   int fd= alarm->watch_fd;
+   char msgbuf[128];
+   // Is it still the same socket that we intended to watch?
+   if (!socketalarm_fd_is_same(alarm)) {
+      // fd was closed/reused.  If user watching event CLOSE, then trigger the actions,
+      // else assume that the host program took care of the socket and doesn't want
+      // the alarm.
+      if (alarm->event_mask & EVENT_CLOSE)
+         trigger= true;
+      else
+         socketalarm_cur_action_set(alarm, alarm->action_count);
+   }
+   else {
+      trigger= ((alarm->event_mask & EVENT_SHUT) && (revents &
+      #ifdef POLLRDHUP
+                  (POLLHUP|POLLRDHUP|POLLERR)
+      #else
+                  (POLLHUP|POLLERR)
+      #endif
+               ))
+            || ((alarm->event_mask & EVENT_IN) && (revents & POLLIN))
+            || ((alarm->event_mask & EVENT_PRI) && (revents & POLLPRI));
+      // Now the tricky one, EVENT_EOF...
+      if (!trigger && (alarm->event_mask & EVENT_EOF) && (alarm->unwaitable || (revents & POLLIN))) {
          #ifdef POLLRDHUP
-         if (events & EVENT_SHUT)
-            pollset[poll_i].events= POLLRDHUP;
+         if (revents & (POLLHUP|POLLRDHUP))
+         #else
+         if (revents & POLLHUP)
          #endif
-         if (events & EVENT_EOF) {
-            // If a fd gets data in the queue, there is no way to wait exclusively
-            // for the EOF event.  We have to wake up periodically to check the socket.
-            if (alarm->unwaitable) // will be set if found data queued in the buffer
-               delay= 500;
+            alarm->peer_shut= true;
+         // While data is queued, there can't be an EOF until the peer shuts
+         // down its side, and for TCP the connection state tells whether it
+         // has without needing to look at the data.
+         if (!(alarm->unwaitable && !alarm->peer_shut && get_tcp_peer_shut(fd) == 0)) {
+            // Only need to know whether there is at least one byte.
+            int avail= recv(fd, msgbuf, 1, MSG_DONTWAIT|MSG_PEEK);
+            if (avail == 0)
+               // This the zero-length read that means EOF
+               trigger= true;
             else
-               pollset[poll_i].events= POLLIN;
+               // else if there is data on the socket, we are in the "unwaitable" condition
+               // else, error conditions are not "EOF" and can still be waited using POLLIN.
+               alarm->unwaitable= (avail > 0);
          }
-         if (events & EVENT_IN)
-            pollset[poll_i].events= POLLIN;
-         if (events & EVENT_PRI)
-            pollset[poll_i].events= POLLPRI;
-         if (events & EVENT_CLOSE) {
-            // According to poll docs, it is a bug to assume closing a socket in one thread
-            // will wake a 'poll' in another thread, so if the user wants to know about this
-            // condition, we have to loop more quickly.
-            delay= 500;
+      }
+      // We're playing with race conditions, so make sure one more time that we're
+      // triggering on the socket we expected.
+      if (trigger) {
+         if (!socketalarm_fd_is_same(alarm) && !(alarm->event_mask & EVENT_CLOSE)) {
+            socketalarm_cur_action_set(alarm, alarm->action_count);
+            trigger= false;
          }
       }
    }
-   pthread_mutex_unlock(&watch_list_mutex);
+   if (trigger)
+      watch_exec_enqueue(alarm);
+   // A triggered or cancelled alarm no longer needs its fd watched, and an
+   // unwaitable one needs different flags.
+   if (alarm->cur_action != -1 || alarm->unwaitable != was_unwaitable || alarm->peer_shut != was_peer_shut)
+      watch_fd_sync(fd);
+   watch_recheck_schedule(alarm, (alarm->unwaitable && !was_unwaitable) || alarm->peer_shut != was_peer_shut);
+   if (!watch_timer_update(alarm))
+      perror("mmap");
+}
 
-   // If there is a defined wake-time, truncate the delay if the wake-time comes first
-   if (wake_time.tv_nsec != -1) {
-      struct timespec now_ts= { 0, -1 };
-      if (lazy_build_now_ts(&now_ts)) {
-         // subtract to find out delay. poll only has millisecond precision anyway.
-         int wake_delay= ((long)wake_time.tv_sec - (long)now_ts.tv_sec) * 1000
-            + (wake_time.tv_nsec - now_ts.tv_nsec)/1000000;
-         if (wake_delay < delay)
-            delay= wake_delay;
+// Check each untriggered alarm on 'fd' against the poll flags the kernel
+// reported for it, or reap the 'spawn' child if it is a pidfd, or read the
+// 'send' connection.  Must hold watch_list_mutex.
+static void watch_fd_dispatch(int fd, int revents) {
+   struct socketalarm *alarm, *next;
+   if (fd < 0 || fd >= watch_fds_alloc)
+      return;
+   if (watch_fds[fd].spawn_pid && (revents & POLLIN))
+      watch_spawn_reap(fd);
+   if (watch_fds[fd].linger && revents)
+      watch_linger_read(fd);
+   for (alarm= watch_fds[fd].alarms; alarm; alarm= next) {
+      next= alarm->fd_next;
+      if (alarm->cur_action == -1)
+         watch_alarm_check(alarm, revents);
+   }
+}
+
+void* watch_thread_main(void* unused) {
+   while (do_watch()) {}
+   return NULL;
+}
+
+// Update the pollset for the fds whose alarms changed since last time.
+// Must hold watch_list_mutex.
+static bool watch_pollset_apply_changes() {
+   int i;
+   for (i= 0; i < watch_fd_changes_count; i++) {
+      int fd= watch_fd_changes[i];
+      watch_fds[fd].change_queued= false;
+      if (!watch_pollset_update(fd))
+         return false;
+   }
+   watch_fd_changes_count= 0;
+   return true;
+}
+
+bool do_watch() {
+   #ifdef HAVE_EPOLL
+   struct epoll_event events[64];
+   #endif
+   struct timespec wake_time= { 0, -1 };
+   int n_events= 0, i, delay= 10000;
+   bool control_ready= false;
+   #ifdef WATCHTHREAD_DEBUGGING
+   char msgbuf[128];
+   #endif
+   
+   if (pthread_mutex_lock(&watch_list_mutex))
+      abort(); // should never fail
+   if (watch_backend == WATCH_BACKEND_POLL) {
+      // The pollset is kept between iterations, and Perl's thread sends the
+      // list of fds whose alarms changed since last time.
+      if (!watch_pollset_count) {
+         if (!watch_buf_grow((void**) &watch_pollset, &watch_pollset_alloc, sizeof(struct pollfd), 1)) {
+            pthread_mutex_unlock(&watch_list_mutex);
+            perror("mmap");
+            return false;
+         }
+         // first fd is always our control socket
+         watch_pollset[0].fd= control_pipe[0];
+         watch_pollset[0].events= POLLIN;
+         watch_pollset_count= 1;
+      }
+      if (!watch_pollset_apply_changes()) {
+         pthread_mutex_unlock(&watch_list_mutex);
+         perror("mmap");
+         return false;
       }
    }
-   WATCHTHREAD_DEBUG("poll(n=%d delay=%d)\n", n_poll, delay);
-   if (poll(pollset, n_poll, delay < 0? 0 : delay) < 0) {
-      perror("poll");
-      return false;
+   WATCHTHREAD_DEBUG("watch_thread loop iter, watch_list_count=%d\n", watch_list_count);
+   // If any socketalarm is stopped at a 'sleep' command or due to be rechecked,
+   // the earliest one is at the top of the timer heap.
+   if (watch_timer_count)
+      wake_time= *watch_timer_ts(watch_timers[0]);
+   // There are only ever a few 'send' connections waiting for their peer.
+   for (i= 0; i < watch_linger_count; i++) {
+      struct timespec *ts= &watch_fds[watch_lingers[i]].linger_ts;
+      if (wake_time.tv_nsec == -1 || timespec_cmp(ts, &wake_time) < 0)
+         wake_time= *ts;
    }
-   for (i= 0; i < n_poll; i++) {
-      int e= pollset[i].revents;
-      WATCHTHREAD_DEBUG("  fd=%3d revents=%02X (%s%s%s%s%s%s%s)\n", pollset[i].fd, e,
-         e&POLLIN? " IN":"", e&POLLPRI? " PRI":"", e&POLLOUT? " OUT":"",
-      #ifdef POLLRDHUP
-         e&POLLRDHUP? " RDHUP":"",
+   pthread_mutex_unlock(&watch_list_mutex);
+
+   #ifdef HAVE_EPOLL
+   if (watch_backend == WATCH_BACKEND_EPOLL) {
+      // The timerfd fires at the exact wake-time, so epoll_wait's timeout is
+      // only a fallback.
+      if (timespec_cmp(&wake_time, &watch_timerfd_ts) != 0) {
+         struct itimerspec its;
+         memset(&its, 0, sizeof(its));
+         if (wake_time.tv_nsec != -1) {
+            its.it_value= wake_time;
+            // a zero it_value would disarm it, but any time in the past fires
+            if (!its.it_value.tv_sec && !its.it_value.tv_nsec)
+               its.it_value.tv_nsec= 1;
+         }
+         // else zero it_value disarms the timer
+         if (timerfd_settime(watch_timerfd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
+            perror("timerfd_settime");
+         watch_timerfd_ts= wake_time;
+      }
+      WATCHTHREAD_DEBUG("epoll_wait(delay=%d)\n", delay);
+      n_events= epoll_wait(epoll_fd, events, sizeof(events)/sizeof(*events), delay < 0? 0 : delay);
+      if (n_events < 0) {
+         if (errno == EINTR)
+            return true;
+         perror("epoll_wait");
+         return false;
+      }
+      for (i= 0; i < n_events; i++) {
+         int fd= WATCH_EPOLL_FD(events[i].data.u64);
+         WATCHTHREAD_DEBUG("  fd=%3d events=%02X\n", fd, (int) events[i].events);
+         if (fd == control_pipe[0])
+            control_ready= true;
+         else if (fd == watch_timerfd) {
+            uint64_t expirations;
+            if (read(watch_timerfd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+               perror("read(timerfd)");
+            // Once expired, it is disarmed, so the next iteration needs to
+            // arm it again.
+            watch_timerfd_ts.tv_nsec= -1;
+         }
+      }
+   }
+   else
+   #endif
+   {
+      struct timespec timeout= { delay / 1000, (delay % 1000) * 1000000 };
+      // If there is a defined wake-time, truncate the timeout if the wake-time comes first
+      if (wake_time.tv_nsec != -1) {
+         struct timespec now_ts= { 0, -1 }, wake_delay;
+         if (lazy_build_now_ts(&now_ts)) {
+            wake_delay.tv_sec= wake_time.tv_sec - now_ts.tv_sec;
+            wake_delay.tv_nsec= wake_time.tv_nsec - now_ts.tv_nsec;
+            if (wake_delay.tv_nsec < 0) {
+               wake_delay.tv_nsec += 1000000000;
+               wake_delay.tv_sec--;
+            }
+            if (wake_delay.tv_sec < 0)
+               wake_delay.tv_sec= wake_delay.tv_nsec= 0;
+            if (timespec_cmp(&wake_delay, &timeout) < 0)
+               timeout= wake_delay;
+         }
+      }
+      // Perl's thread never modifies the pollset, so it is safe to use
+      // without the mutex.
+      WATCHTHREAD_DEBUG("poll(n=%d timeout=%ld.%09ld)\n", (int) watch_pollset_count, (long) timeout.tv_sec, (long) timeout.tv_nsec);
+      #ifdef HAVE_PPOLL
+      if (ppoll(watch_pollset, watch_pollset_count, &timeout, NULL) < 0 && errno != EINTR) {
+         perror("ppoll");
+         return false;
+      }
       #else
-         "",
+      // round up, else it would wake before the wake-time and spin
+      if (poll(watch_pollset, watch_pollset_count,
+         timeout.tv_sec * 1000 + (timeout.tv_nsec + 999999) / 1000000) < 0 && errno != EINTR
+      ) {
+         perror("poll");
+         return false;
+      }
       #endif
-         e&POLLERR? " ERR":"", e&POLLHUP? " HUP":"", e&POLLNVAL? " NVAL":"");
+      for (i= 0; i < watch_pollset_count; i++) {
+         int e= watch_pollset[i].revents;
+         WATCHTHREAD_DEBUG("  fd=%3d revents=%02X (%s%s%s%s%s%s%s)\n", watch_pollset[i].fd, e,
+            e&POLLIN? " IN":"", e&POLLPRI? " PRI":"", e&POLLOUT? " OUT":"",
+         #ifdef POLLRDHUP
+            e&POLLRDHUP? " RDHUP":"",
+         #else
+            "",
+         #endif
+            e&POLLERR? " ERR":"", e&POLLHUP? " HUP":"", e&POLLNVAL? " NVAL":"");
+      }
+      control_ready= (watch_pollset[0].revents & POLLIN) != 0;
    }
    
-   // First, did we get new control messages?
-   if (pollset[0].revents & POLLIN) {
-      char msg;
-      int ret= read(pollset[0].fd, &msg, 1);
-      if (ret != 1) { // should never fail
-         WATCHTHREAD_DEBUG("read(control_pipe): %d, errno %m, terminating watch_thread\n", ret);
+   // First, were we woken by Perl's thread?  Consume all the wakeups at once,
+   // then clear the flag so that the next change writes a new one.  (in that
+   // order, else a wakeup could be consumed without the flag being cleared)
+   if (control_ready && !watch_thread_drain()) { // should never fail
+      WATCHTHREAD_DEBUG("read(control_pipe): errno %m, terminating watch_thread\n");
+      return false;
+   }
+   if (pthread_mutex_lock(&watch_list_mutex))
+      abort(); // should never fail
+   if (control_ready) {
+      watch_wake_pending= false;
+      if (watch_terminating) { // intentional exit
+         pthread_mutex_unlock(&watch_list_mutex);
+         WATCHTHREAD_DEBUG("terminate received\n");
          return false;
       }
-      if (msg == CONTROL_TERMINATE) {// intentional exit
-         WATCHTHREAD_DEBUG("terminate received\n");
+      // else alarms were added or removed.  Apply that to the pollset, but
+      // still handle the events collected this round, so that steady start
+      // and cancel calls can't hold back the alarms on ready sockets.
+      // (epoll's interest set is updated by Perl's thread directly)
+      WATCHTHREAD_DEBUG("got wakeup\n");
+      if (watch_backend == WATCH_BACKEND_POLL && !watch_pollset_apply_changes()) {
+         pthread_mutex_unlock(&watch_list_mutex);
+         perror("mmap");
          return false;
       }
-      // else its CONTROL_REWATCH, which means we should start over with new alarms to watch
-      WATCHTHREAD_DEBUG("got REWATCH, starting over\n");
-      return true;
    }
    
    // Now, process all of the socketalarms using the statuses from the pollfd
-   if (pthread_mutex_lock(&watch_list_mutex))
-      abort(); // should never fail
-   for (i= 0, n= watch_list_count; i < n; i++) {
-      struct socketalarm *alarm= watch_list[i];
-      // If it has not been triggered yet, see if it is now
-      if (alarm->cur_action == -1) {
-         bool trigger= false;
-         int fd= alarm->watch_fd, revents;
-         size_t pollfd_node;
-         struct stat statbuf;
-         // Is it still the same socket that we intended to watch?
-         if (fstat(fd, &statbuf) != 0
-            || statbuf.st_dev != alarm->watch_fd_dev
-            || statbuf.st_ino != alarm->watch_fd_ino
-         ) {
-            // fd was closed/reused.  If user watching event CLOSE, then trigger the actions,
-            // else assume that the host program took care of the socket and doesn't want
-            // the alarm.
-            if (alarm->event_mask & EVENT_CLOSE)
-               trigger= true;
+   // Check the untriggered alarms on the fds that had activity.  The others
+   // are only checked when their recheck comes due.
+   #ifdef HAVE_EPOLL
+   if (watch_backend == WATCH_BACKEND_EPOLL) {
+      for (i= 0; i < n_events; i++) {
+         int fd= WATCH_EPOLL_FD(events[i].data.u64);
+         if (fd == control_pipe[0] || fd == watch_timerfd)
+            continue;
+         // Ignore events of a registration that a newer one replaced (the
+         // user closed the fd, and it now refers to another file)
+         if (fd >= watch_fds_alloc || !watch_fds[fd].registered
+            || watch_fds[fd].epoll_gen != WATCH_EPOLL_GEN(events[i].data.u64))
+            continue;
+         watch_fd_dispatch(fd, events[i].events);
+         // The registration is one-shot, so re-arm it with whatever flags its
+         // alarms still need.
+         if (watch_fds[fd].registered)
+            watch_fd_sync(fd);
+      }
+   }
+   else
+   #endif
+   {
+      // Checking an alarm can remove its fd from the pollset, which moves the
+      // final slot into its place, so go backward to visit every slot once.
+      // (the pollset can't have changed otherwise, since only this thread
+      // modifies it)
+      for (i= watch_pollset_count-1; i > 0; i--)
+         if (watch_pollset[i].revents)
+            watch_fd_dispatch(watch_pollset[i].fd, watch_pollset[i].revents);
+   }
+   // Resume any alarms whose 'sleep' has expired, and recheck the ones that
+   // can't be waited on.
+   if (watch_timer_count) {
+      struct timespec now_ts= { 0, -1 };
+      if (lazy_build_now_ts(&now_ts)) {
+         while (watch_timer_count && timespec_cmp(watch_timer_ts(watch_timers[0]), &now_ts) <= 0) {
+            struct socketalarm *alarm= watch_timers[0];
+            watch_timer_remove(alarm);
+            if (alarm->cur_action == -1)
+               watch_alarm_check(alarm, 0);
             else
-               alarm->cur_action= alarm->action_count;
-         }
-         else {
-            int poll_i= -1 + (int) pollfd_rbhash_find(pollset+capacity, capacity, fd & (buckets-1), fd);
-            // Did we poll this fd?
-            if (poll_i < 0)
-               // can only happen if watch_list changed while we let go of the mutex (or a bug in rbhash)
-               continue;
-
-            revents= pollset[poll_i].revents;
-            trigger= ((alarm->event_mask & EVENT_SHUT) && (revents &
-            #ifdef POLLRDHUP
-                        (POLLHUP|POLLRDHUP|POLLERR)
-            #else
-                        (POLLHUP|POLLERR)
-            #endif
-                     ))
-                  || ((alarm->event_mask & EVENT_IN) && (revents & POLLIN))
-                  || ((alarm->event_mask & EVENT_PRI) && (revents & POLLPRI));
-            // Now the tricky one, EVENT_EOF...
-            if (!trigger && (alarm->event_mask & EVENT_EOF) && (alarm->unwaitable || (revents & POLLIN))) {
-               int avail= recv(fd, msgbuf, sizeof(msgbuf), MSG_DONTWAIT|MSG_PEEK);
-               if (avail == 0)
-                  // This the zero-length read that means EOF
-                  trigger= true;
-               else
-                  // else if there is data on the socket, we are in the "unwaitable" condition
-                  // else, error conditions are not "EOF" and can still be waited using POLLIN.
-                  alarm->unwaitable= (avail > 0);
-            }
-            // We're playing with race conditions, so make sure one more time that we're
-            // triggering on the socket we expected.
-            if (trigger) {
-               if ((fstat(fd, &statbuf) != 0
-                  || statbuf.st_dev != alarm->watch_fd_dev
-                  || statbuf.st_ino != alarm->watch_fd_ino
-                  ) && !(alarm->event_mask & EVENT_CLOSE)
-               ) {
-                  alarm->cur_action= alarm->action_count;
-                  trigger= false;
-               }
-            }
+               watch_exec_enqueue(alarm);
          }
-         if (!trigger)
-            continue; // don't exec_actions
       }
-      socketalarm_exec_actions(alarm);
+   }
+   // Close the 'send' connections whose peer didn't close them by the deadline
+   if (watch_linger_count) {
+      struct timespec now_ts= { 0, -1 };
+      if (lazy_build_now_ts(&now_ts)) {
+         for (i= watch_linger_count-1; i >= 0; i--)
+            if (timespec_cmp(&watch_fds[watch_lingers[i]].linger_ts, &now_ts) <= 0)
+               watch_linger_end(watch_lingers[i]);
+      }
    }
    pthread_mutex_unlock(&watch_list_mutex);
    return true;
 }
 
-// May only be called by Perl's thread
-static bool watch_list_add(struct socketalarm *alarm) {
-   int i;
-   const char *error= NULL;
+// Wake the watch thread, unless there is already a wakeup that it hasn't
+// consumed yet.  Must hold watch_list_mutex.
+static bool watch_thread_wake() {
+   if (!watch_wake_pending) {
+      #ifdef HAVE_EVENTFD
+      uint64_t n= 1;
+      if (write(control_pipe[1], &n, sizeof(n)) != sizeof(n))
+         return false;
+      #else
+      char msg= 'w';
+      if (write(control_pipe[1], &msg, 1) != 1)
+         return false;
+      #endif
+      watch_wake_pending= true;
+   }
+   return true;
+}
 
+// Read all pending wakeups from the (non-blocking) control fd.
+// Only called by the watch thread.  Returns false if the fd is broken.
+static bool watch_thread_drain() {
+   char buf[64]; // eventfd needs at least 8
+   int ret;
+   while ((ret= read(control_pipe[0], buf, sizeof(buf))) > 0) {}
+   return ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+}
+
+#ifdef HAVE_EPOLL
+// Create the epoll instance, and register the control pipe and timerfd with it.
+// Must hold watch_list_mutex.
+static bool watch_epoll_init() {
+   struct epoll_event ev;
+   int fd;
+   if ((epoll_fd= epoll_create1(EPOLL_CLOEXEC)) < 0)
+      return false;
+   memset(&ev, 0, sizeof(ev));
+   ev.events= EPOLLIN;
+   ev.data.u64= WATCH_EPOLL_DATA(control_pipe[0], 0);
+   if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, control_pipe[0], &ev) != 0)
+      goto fail;
+   // 'sleep' deadlines are delivered by a timerfd, for sub-millisecond precision
+   if ((watch_timerfd= timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC)) < 0)
+      goto fail;
+   ev.data.u64= WATCH_EPOLL_DATA(watch_timerfd, 0);
+   if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, watch_timerfd, &ev) != 0)
+      goto fail;
+   // Alarms might have been linked to the fd table before the thread started
+   for (fd= 0; fd < watch_fds_alloc; fd++)
+      if (watch_fds[fd].alarms)
+         watch_fd_sync(fd);
+   return true;
+   fail:
+   if (watch_timerfd >= 0)
+      close(watch_timerfd);
+   close(epoll_fd);
+   epoll_fd= watch_timerfd= -1;
+   return false;
+}
+#endif
+
+static const char *watch_backend_name() {
+   return watch_backend == WATCH_BACKEND_EPOLL? "epoll" : "poll";
+}
+
+// The backend can only be changed before the watch thread starts, since the
+// epoll backend keeps its registrations in the kernel.
+static void watch_backend_set(const char *name) {
+   int backend;
+   if (strcmp(name, "poll") == 0)
+      backend= WATCH_BACKEND_POLL;
+   #ifdef HAVE_EPOLL
+   else if (strcmp(name, "epoll") == 0)
+      backend= WATCH_BACKEND_EPOLL;
+   #endif
+   else
+      croak("Unsupported watch backend '%s'", name);
    if (pthread_mutex_lock(&watch_list_mutex))
       croak("mutex_lock failed");
+   if (control_pipe[1] >= 0 && backend != watch_backend) {
+      pthread_mutex_unlock(&watch_list_mutex);
+      croak("Can't change watch backend after the watch thread has started");
+   }
+   watch_backend= backend;
+   pthread_mutex_unlock(&watch_list_mutex);
+}
+
+// Add the alarms to the watch list, and make sure the watch thread is running
+// and knows about them, with a single wakeup.  Stores into 'added' how many
+// were not already on the list.  Returns an error message, or NULL.
+// Must hold watch_list_mutex.  May only be called by Perl's thread.
+static const char *watch_list_add_locked(struct socketalarm **alarms, int n, int *added) {
+   int i, n_added= 0;
+   const char *error= NULL;
+
+   // An alarm that finished its actions gets removed by the cleanup below and
+   // then reset, which must wait until the executor lets go of it.
+   for (i= 0; i < n; i++)
+      while (alarms[i]->executing && socketalarm_cur_action_get(alarms[i]) >= alarms[i]->action_count)
+         pthread_cond_wait(&watch_exec_done, &watch_list_mutex);
 
    if (!watch_list) {
       Newxz(watch_list, 16, struct socketalarm * volatile);
@@ -236,31 +1031,30 @@ static bool watch_list_add(struct socketalarm *alarm) {
    }
    else {
       // Clean up completed watches
-      for (i= watch_list_count-1; i >= 0; --i) {
-         if (watch_list[i]->cur_action >= watch_list[i]->action_count) {
-            watch_list[i]->list_ofs= -1;
-            if (--watch_list_count > i) {
-               watch_list[i]= watch_list[watch_list_count];
-               watch_list[i]->list_ofs= i;
-            }
-            watch_list[watch_list_count]= NULL;
-         }
-      }
-      // allocate more if needed
-      if (watch_list_count >= watch_list_alloc) {
-         Renew(watch_list, watch_list_alloc*2, struct socketalarm * volatile);
-         watch_list_alloc= watch_list_alloc*2;
-      }
+      watch_list_cleanup();
+   }
+   // allocate more if needed
+   while (watch_list_count + n > watch_list_alloc) {
+      Renew(watch_list, watch_list_alloc*2, struct socketalarm * volatile);
+      watch_list_alloc= watch_list_alloc*2;
    }
 
-   i= alarm->list_ofs;
-   if (i < 0) { // only add if not already added
+   for (i= 0; i < n && !error; i++) {
+      struct socketalarm *alarm= alarms[i];
+      if (alarm->list_ofs >= 0) // only add if not already added
+         continue;
       alarm->list_ofs= watch_list_count;
       watch_list[watch_list_count++]= alarm;
       // Initialize fields that watcher uses to track status
-      alarm->cur_action= -1;
+      socketalarm_cur_action_set(alarm, -1);
       alarm->wake_ts.tv_nsec= -1;
+      alarm->timer_idx= -1;
       alarm->unwaitable= false;
+      alarm->peer_shut= false;
+      watch_recheck_schedule(alarm, true);
+      if (!watch_fd_link(alarm) || !watch_timer_update(alarm))
+         error= "mmap() failed";
+      ++n_added;
    }
    
    // If the thread is not running, start it.  Also create pipe if needed.
@@ -269,8 +1063,19 @@ static bool watch_list_add(struct socketalarm *alarm) {
       sigset_t mask, orig;
       sigfillset(&mask);
 
+      #ifdef HAVE_EVENTFD
+      if ((control_pipe[0]= control_pipe[1]= eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC)) < 0)
+         error= "eventfd() failed";
+      #else
       if (pipe(control_pipe) != 0)
          error= "pipe() failed";
+      else if (fcntl(control_pipe[0], F_SETFL, O_NONBLOCK) != 0)
+         error= "fcntl(O_NONBLOCK) failed";
+      #endif
+      #ifdef HAVE_EPOLL
+      else if (watch_backend == WATCH_BACKEND_EPOLL && !watch_epoll_init())
+         error= "epoll_create() failed";
+      #endif
       // Block all signals before creating thread so that the new thread inherits it,
       // then restore the original signals.
       else if (pthread_sigmask(SIG_SETMASK, &mask, &orig) != 0)
@@ -279,43 +1084,176 @@ static bool watch_list_add(struct socketalarm *alarm) {
          error= "pthread_create failed";
       else if (pthread_sigmask(SIG_SETMASK, &orig, NULL) != 0)
          error= "pthread_sigmask(UNBLOCK) failed";
-   } else {
-      char msg= CONTROL_REWATCH;
-      if (write(control_pipe[1], &msg, 1) != 1)
-         error= "failed to notify watch_thread";
-   }
+   } else if (!watch_thread_wake())
+      error= "failed to notify watch_thread";
+   *added= n_added;
+   return error;
+}
+
+// Start watching all 'n' alarms.  Returns how many weren't already active.
+// May only be called by Perl's thread
+static int watch_list_add_all(struct socketalarm **alarms, int n) {
+   const char *error;
+   int added;
+   if (pthread_mutex_lock(&watch_list_mutex))
+      croak("mutex_lock failed");
+   error= watch_list_add_locked(alarms, n, &added);
    pthread_mutex_unlock(&watch_list_mutex);
    if (error)
       croak(error);
-   return i < 0;
+   return added;
+}
+
+// May only be called by Perl's thread
+static bool watch_list_add(struct socketalarm *alarm) {
+   return watch_list_add_all(&alarm, 1) > 0;
+}
+
+// Perl's thread closed 'fd', so the EVENT_CLOSE alarms on it can be checked
+// now instead of at their next recheck.
+static void watch_fd_closed(int fd) {
+   struct socketalarm *alarm;
+   bool found= false;
+   if (pthread_mutex_lock(&watch_list_mutex))
+      croak("mutex_lock failed");
+   if (fd >= 0 && fd < watch_fds_alloc) {
+      for (alarm= watch_fds[fd].alarms; alarm; alarm= alarm->fd_next) {
+         if (alarm->cur_action == -1 && (alarm->event_mask & EVENT_CLOSE)) {
+            // earliest possible deadline
+            alarm->recheck_ts.tv_sec= 0;
+            alarm->recheck_ts.tv_nsec= 0;
+            if (watch_timer_update(alarm))
+               found= true;
+         }
+      }
+   }
+   if (found && control_pipe[1] >= 0 && !watch_thread_wake()) {
+      pthread_mutex_unlock(&watch_list_mutex);
+      croak("failed to notify watch_thread");
+   }
+   pthread_mutex_unlock(&watch_list_mutex);
+}
+
+static void watch_recheck_interval_set(double min, double max) {
+   if (!(min > 0 && max >= min))
+      croak("recheck_interval requires 0 < min <= max");
+   if (pthread_mutex_lock(&watch_list_mutex))
+      croak("mutex_lock failed");
+   watch_recheck_min= min;
+   watch_recheck_max= max;
+   pthread_mutex_unlock(&watch_list_mutex);
 }
 
-// need to lock mutex before accessing concurrent alarm fields
+// Doesn't need the mutex, since cur_action is written atomically
 static void watch_list_item_get_status(struct socketalarm *alarm, int *cur_action_out) {
+   if (cur_action_out) *cur_action_out= socketalarm_cur_action_get(alarm);
+}
+
+// Copy the exit status of each 'spawn' action, or -1 if there isn't one yet.
+static void watch_list_item_get_results(struct socketalarm *alarm, int *status_out) {
+   int i;
    if (pthread_mutex_lock(&watch_list_mutex))
       croak("mutex_lock failed");
+   for (i= 0; i < alarm->action_count; i++)
+      status_out[i]= alarm->actions[i].op == ACT_SPAWN? alarm->actions[i].act.run.status : -1;
+   pthread_mutex_unlock(&watch_list_mutex);
+}
 
-   if (cur_action_out) *cur_action_out= alarm->cur_action;
+// Remove up to 'max' alarms from the front of the queue of triggered alarms.
+// Returns how many.
+static int watch_fired_take(struct socketalarm **out, int max) {
+   char buf[64]; // eventfd needs at least 8
+   int n= 0;
+   if (pthread_mutex_lock(&watch_list_mutex))
+      croak("mutex_lock failed");
+   // Reset the notify fd before taking alarms, so that any alarm queued after
+   // this makes it readable again.
+   if (watch_notify_pending) {
+      while (read(watch_notify_fd[0], buf, sizeof(buf)) > 0) {}
+      watch_notify_pending= false;
+   }
+   while (n < max && watch_fired_head) {
+      out[n]= watch_fired_head;
+      out[n]->fired_queued= false;
+      if (!(watch_fired_head= out[n]->fired_next))
+         watch_fired_tail= NULL;
+      ++n;
+   }
+   pthread_mutex_unlock(&watch_list_mutex);
+   return n;
+}
 
+// Return the fd that is readable while triggered alarms wait for
+// drain_triggered, creating it on first use.
+static int watch_notify_fd_get() {
+   const char *error= NULL;
+   if (pthread_mutex_lock(&watch_list_mutex))
+      croak("mutex_lock failed");
+   if (watch_notify_fd[0] < 0) {
+      #ifdef HAVE_EVENTFD
+      if ((watch_notify_fd[0]= watch_notify_fd[1]= eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC)) < 0)
+         error= "eventfd() failed";
+      #else
+      if (pipe(watch_notify_fd) != 0)
+         error= "pipe() failed";
+      else if (fcntl(watch_notify_fd[0], F_SETFL, O_NONBLOCK) != 0
+         || fcntl(watch_notify_fd[1], F_SETFL, O_NONBLOCK) != 0
+         || fcntl(watch_notify_fd[0], F_SETFD, FD_CLOEXEC) != 0
+         || fcntl(watch_notify_fd[1], F_SETFD, FD_CLOEXEC) != 0)
+         error= "fcntl() failed";
+      #endif
+      if (error)
+         watch_notify_fd[0]= watch_notify_fd[1]= -1;
+      else if (watch_fired_head)
+         watch_notify();
+   }
    pthread_mutex_unlock(&watch_list_mutex);
+   if (error)
+      croak(error);
+   return watch_notify_fd[0];
 }
 
-// May only be called by Perl's thread
-static bool watch_list_remove(struct socketalarm *alarm) {
-   int i;
+// The watch thread must stop recording the status of the alarm's 'spawn'
+// children (it still reaps them), and their results are cleared.
+// Must hold watch_list_mutex.
+static void watch_spawn_detach(struct socketalarm *alarm) {
+   int i, fd;
+   for (i= 0; i < alarm->action_count; i++) {
+      struct action *act= alarm->actions + i;
+      if (act->op != ACT_SPAWN)
+         continue;
+      if ((fd= act->act.run.pidfd) >= 0 && fd < watch_fds_alloc && watch_fds[fd].spawn == act)
+         watch_fds[fd].spawn= NULL;
+      act->act.run.pid= 0;
+      act->act.run.pidfd= -1;
+      act->act.run.status= -1;
+   }
+}
+
+// The alarm is about to be freed, so remove it from the queue of triggered
+// alarms, and the watch thread must stop recording the status of its
+// children, though it still reaps them.  Call after watch_list_remove, so
+// that none of its actions are running.
+static void watch_list_forget(struct socketalarm *alarm) {
    if (pthread_mutex_lock(&watch_list_mutex))
       croak("mutex_lock failed");
+   watch_fired_unlink(alarm);
+   watch_spawn_detach(alarm);
+   pthread_mutex_unlock(&watch_list_mutex);
+}
+
+// Take the alarm off the watch list.  The caller must wake the watch thread
+// if this returns true.  Must hold watch_list_mutex.  May only be called by
+// Perl's thread.
+static bool watch_list_remove_locked(struct socketalarm *alarm) {
+   int i;
+   // If its actions are running, wait for them, since the caller might be
+   // about to free it.  If they haven't started yet, they won't.
+   if (alarm->executing && !watch_exec_dequeue(alarm))
+      while (alarm->executing)
+         pthread_cond_wait(&watch_exec_done, &watch_list_mutex);
    // Clean up completed watches
-   for (i= watch_list_count-1; i >= 0; --i) {
-      if (watch_list[i]->cur_action >= watch_list[i]->action_count) {
-         watch_list[i]->list_ofs= -1;
-         if (--watch_list_count > i) {
-            watch_list[i]= watch_list[watch_list_count];
-            watch_list[i]->list_ofs= i;
-         }
-         watch_list[watch_list_count]= NULL;
-      }
-   }
+   watch_list_cleanup();
    i= alarm->list_ofs;
    if (i >= 0) {
       // fill the hole in the list by moving the final item
@@ -325,19 +1263,62 @@ static bool watch_list_remove(struct socketalarm *alarm) {
       }
       --watch_list_count;
       alarm->list_ofs= -1;
+      watch_fd_unlink(alarm);
+      watch_timer_remove(alarm);
+   }
+   return i >= 0;
+}
 
-      // This one was still an active watch, so need to notify thread
-      //  not to listen for it anymore
-      if (control_pipe[1] >= 0) {
-         char msg= CONTROL_REWATCH;
-         if (write(control_pipe[1], &msg, 1) != 1) {
-            pthread_mutex_unlock(&watch_list_mutex);
-            croak("failed to notify watch_thread");
-         }
-      }
+// Stop watching all 'n' alarms, with a single wakeup of the watch thread.
+// Returns how many were active.  May only be called by Perl's thread
+static int watch_list_remove_all(struct socketalarm **alarms, int n) {
+   int i, removed= 0;
+   if (pthread_mutex_lock(&watch_list_mutex))
+      croak("mutex_lock failed");
+   for (i= 0; i < n; i++)
+      if (watch_list_remove_locked(alarms[i]))
+         ++removed;
+   // Some were still active watches, so need to notify thread
+   //  not to listen for them anymore
+   if (removed && control_pipe[1] >= 0 && !watch_thread_wake()) {
+      pthread_mutex_unlock(&watch_list_mutex);
+      croak("failed to notify watch_thread");
    }
    pthread_mutex_unlock(&watch_list_mutex);
-   return i >= 0;
+   return removed;
+}
+
+// May only be called by Perl's thread
+static bool watch_list_remove(struct socketalarm *alarm) {
+   return watch_list_remove_all(&alarm, 1) > 0;
+}
+
+// Cancel the alarm if needed, clear the results of its previous run, and put
+// it back on the watch list untriggered, in a single critical section.  If
+// 'fd' is not negative, the alarm watches that socket from now on.  Nothing
+// is allocated unless the watch list or fd table need to grow.
+// May only be called by Perl's thread.
+static void watch_list_rearm(struct socketalarm *alarm, int fd, struct stat *statbuf, uint64_t cookie) {
+   const char *error;
+   int added;
+   if (pthread_mutex_lock(&watch_list_mutex))
+      croak("mutex_lock failed");
+   watch_list_remove_locked(alarm);
+   // It starts over untriggered, so drain_triggered must not return it for
+   // the previous time.
+   watch_fired_unlink(alarm);
+   watch_spawn_detach(alarm);
+   if (fd >= 0) {
+      alarm->watch_fd= fd;
+      alarm->watch_fd_dev= statbuf->st_dev;
+      alarm->watch_fd_ino= statbuf->st_ino;
+      alarm->watch_fd_cookie= cookie;
+   }
+   // also wakes the watch thread, which covers the removal
+   error= watch_list_add_locked(&alarm, 1, &added);
+   pthread_mutex_unlock(&watch_list_mutex);
+   if (error)
+      croak(error);
 }
 
 // only called during Perl's END phase.  Just need to let
@@ -350,16 +1331,21 @@ static void shutdown_watch_thread() {
       croak("mutex_lock failed");
    for (i= 0; i < watch_list_count; i++) {
       watch_list[i]->list_ofs= -1;
+      watch_fd_unlink(watch_list[i]);
+      watch_timer_remove(watch_list[i]);
       watch_list[i]= NULL;
    }
    watch_list_count= 0;
+   // Alarms waiting for an executor won't run, and the executors exit after
+   // finishing their current alarm.
+   while (watch_exec_head)
+      watch_exec_dequeue(watch_exec_head);
 
-   // Notify the thread to stop
-   if (control_pipe[1] >= 0) {
-      char msg= CONTROL_TERMINATE;
-      if (write(control_pipe[1], &msg, 1) != 1)
-         warn("write(control_pipe) failed");
-   }
+   // Notify the threads to stop
+   watch_terminating= true;
+   pthread_cond_broadcast(&watch_exec_ready);
+   if (control_pipe[1] >= 0 && !watch_thread_wake())
+      warn("write(control_pipe) failed");
    
    pthread_mutex_unlock(&watch_list_mutex);
    // don't bother unallocating watch_list or closing pipe,
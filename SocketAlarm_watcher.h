@@ -1,18 +1,101 @@
-#define CONTROL_TERMINATE 't'
-#define CONTROL_REWATCH   'r'
+#define WATCH_BACKEND_POLL  1
+#define WATCH_BACKEND_EPOLL 2
+
+// Per-file-descriptor record of the alarms watching it, and the poll flags
+// requested from the kernel on their behalf.  Indexed by fd number.
+// A pidfd of a 'spawn' child is watched the same way, for the child's exit,
+// and so is the connection of a 'send' action, for the peer to close it.
+struct watch_fd {
+   struct socketalarm *alarms; // linked through socketalarm.fd_next
+   struct action *spawn;       // 'spawn' action to receive the exit status, if any
+   pid_t spawn_pid;            // child that this pidfd refers to, or 0
+   bool linger;                // whether this is a 'send' connection
+   struct timespec linger_ts;  // when to stop waiting for its peer to close it
+   short events;               // poll flags currently registered
+   int poll_slot;              // index within watch_pollset, if still valid
+   bool registered;            // whether fd is in the epoll interest set
+   uint32_t epoll_gen;         // generation of that registration, in its event data
+   bool change_queued;         // whether fd is in watch_fd_changes
+};
 
 static pthread_t        watch_thread;
-static int              control_pipe[2]= { -1, -1 };
+static int              control_pipe[2]= { -1, -1 }; // both are one eventfd, if available
+static bool             watch_wake_pending= false,
+                        watch_terminating= false;
 static pthread_mutex_t  watch_list_mutex= PTHREAD_MUTEX_INITIALIZER;
 static int     volatile watch_list_count= 0,
                         watch_list_alloc= 0;
 static struct socketalarm
     *volatile *volatile watch_list= NULL;
+// These grow with mmap, so that executor threads can add pidfds to them.
+static struct watch_fd *watch_fds= NULL;
+static size_t           watch_fds_alloc= 0;
+// fds whose pollset slot needs updated by the watch thread
+static int             *watch_fd_changes= NULL;
+static size_t           watch_fd_changes_alloc= 0;
+static int              watch_fd_changes_count= 0;
+// fds of 'send' connections waiting for their peer to close them
+static int             *watch_lingers= NULL;
+static size_t           watch_lingers_alloc= 0;
+static int              watch_linger_count= 0;
+#ifdef HAVE_EPOLL
+static int              watch_backend= WATCH_BACKEND_EPOLL;
+#else
+static int              watch_backend= WATCH_BACKEND_POLL;
+#endif
+static int              epoll_fd= -1;
+static int              watch_timerfd= -1;
+static struct timespec  watch_timerfd_ts= { 0, -1 }; // wake_ts the timerfd is set to
+// Heap of alarms waiting for a wake_ts or recheck_ts, earliest first.
+// It grows with mmap, so either thread may modify it while holding the mutex.
+static struct socketalarm **watch_timers= NULL;
+static size_t           watch_timers_alloc= 0;
+static int              watch_timer_count= 0;
+// Triggered alarms waiting for an executor thread, which run the actions
+// without holding the mutex.
+#define WATCH_EXECUTOR_MAX 4
+static struct socketalarm *watch_exec_head= NULL,
+                        *watch_exec_tail= NULL;
+static pthread_cond_t   watch_exec_ready= PTHREAD_COND_INITIALIZER; // queue not empty
+static pthread_cond_t   watch_exec_done= PTHREAD_COND_INITIALIZER;  // an alarm stopped executing
+static int              watch_executor_count= 0,
+                        watch_executor_idle= 0;
+// Alarms that triggered since Perl's thread last drained them, oldest first
+static struct socketalarm *watch_fired_head= NULL,
+                        *watch_fired_tail= NULL;
+// Readable while that queue is not empty, for event loops (one eventfd, if available)
+static int              watch_notify_fd[2]= { -1, -1 };
+static bool             watch_notify_pending= false;
+// Range of the interval for polling sockets that can't be waited on
+static double           watch_recheck_min= 0.05;
+static double           watch_recheck_max= 0.5;
+// Owned by the watch thread
+static struct pollfd   *watch_pollset= NULL;
+static size_t           watch_pollset_alloc= 0;
+static int              watch_pollset_count= 0;
 
 // May only be called by Perl's thread
 static bool watch_list_add(struct socketalarm *alarm);
 // May only be called by Perl's thread
 static bool watch_list_remove(struct socketalarm *alarm);
 static void watch_list_item_get_status(struct socketalarm *alarm, int *cur_action_out);
+static void watch_list_item_get_results(struct socketalarm *alarm, int *status_out);
+// May only be called by Perl's thread
+static void watch_list_forget(struct socketalarm *alarm);
+// May only be called by Perl's thread
+static int watch_fired_take(struct socketalarm **out, int max);
+// May only be called by Perl's thread
+static int watch_notify_fd_get();
+static const char *watch_backend_name();
+// May only be called by Perl's thread
+static void watch_backend_set(const char *name);
+// May only be called by Perl's thread
+static void watch_recheck_interval_set(double min, double max);
+// May only be called by Perl's thread
+static void watch_fd_closed(int fd);
+// Must hold watch_list_mutex
+static bool watch_thread_wake();
+// May only be called by the watch thread
+static bool watch_thread_drain();
 static void shutdown_watch_thread();
 static void* watch_thread_main(void*);
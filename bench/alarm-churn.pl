@@ -0,0 +1,46 @@
+#! /usr/bin/env perl
+# Measure the rate at which alarms can be created, started, cancelled and
+# freed, as a server does once per request, while many long-lived alarms
+# exist so that the allocator is not starting from a clean heap.
+#
+#   perl -Mblib bench/alarm-churn.pl [n_live_alarms] [seconds]
+#
+# Reports alarms per second with the actions given as arrayrefs and as an
+# IO::SocketAlarm::Actions object, and the pool statistics at the end.
+use strict;
+use warnings;
+use Socket ':all';
+use Time::HiRes qw( time );
+use IO::SocketAlarm;
+
+my $n_live= shift // 5000;
+my $seconds= shift // 2;
+
+my @actions= ([ sig => 'SIGUSR1' ], [ shut_rw => 0 ], [ run => '/bin/true', 'a', 'b' ]);
+my @live;
+for (1..$n_live) {
+   socketpair(my $a, my $b, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   push @live, [ $a, $b, IO::SocketAlarm->new(socket => $b, actions => \@actions) ];
+}
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+
+printf "%10s %14s\n", 'actions', 'alarms/sec';
+measure(arrayref => \@actions);
+measure(program => IO::SocketAlarm::Actions->new(@actions));
+my $stats= IO::SocketAlarm->pool_stats;
+print join(' ', map "$_=$stats->{$_}", sort keys %$stats), "\n";
+
+sub measure {
+   my ($label, $actions)= @_;
+   my $n= 0;
+   my $end= time + $seconds;
+   while (time < $end) {
+      for (1..1000) {
+         my $alarm= IO::SocketAlarm->new(socket => $s2, actions => $actions);
+         $alarm->start;
+         $alarm->cancel;
+      }
+      $n += 1000;
+   }
+   printf "%10s %14.0f\n", $label, $n / $seconds;
+}
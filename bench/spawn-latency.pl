@@ -0,0 +1,76 @@
+#! /usr/bin/env perl
+# Measure how long a 'run' action takes to start its command, as the size of
+# the Perl process grows.  Forking copies the page tables of the whole process,
+# so the cost of a fork-based 'run' grows with the heap, while vfork and
+# posix_spawn don't.
+#
+#   perl -Mblib bench/spawn-latency.pl [max_heap_mb] [repeat] [helper]
+#
+# For each heap size, a child process allocates (and touches) that much memory,
+# then repeatedly triggers an alarm whose action is
+#   [ run => 'kill', '-USR1', $$ ]
+# and measures the time from the socket shutdown until the signal arrives.
+# Reports the median and worst.  With 'helper', the spawn helper is started
+# before any heap is allocated, and the commands are started by it instead.
+use strict;
+use warnings;
+use Socket ':all';
+use POSIX ();
+use Time::HiRes qw( time sleep );
+use IO::SocketAlarm;
+
+my $max_mb= shift // 4096;
+my $repeat= shift // 20;
+my $helper= shift;
+my $kill= (grep -x, '/bin/kill', '/usr/bin/kill')[0] or die "Can't find a 'kill' executable\n";
+my @sizes= grep $_ <= $max_mb, 0, 64, 256, 1024, 2048, 4096, 8192;
+
+IO::SocketAlarm->start_spawn_helper if $helper;
+printf "%8s %12s %12s\n", 'heap MB', 'median ms', 'max ms';
+for my $mb (@sizes) {
+   my $result= run_child(sub { measure($mb) });
+   printf "%8d %12.3f %12.3f\n", $mb, split / /, $result;
+}
+
+sub measure {
+   my $mb= shift;
+   # Touch every page, so that they're really mapped
+   my @heap= map { 'x' x (1024*1024) } 1..$mb;
+   my @lat;
+   for (1..$repeat) {
+      socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+      my $got;
+      local $SIG{USR1}= sub { $got= time };
+      my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [[ run => $kill, '-USR1', $$ ]]);
+      $alarm->start;
+      my $start= time;
+      shutdown($s1, SHUT_WR);
+      sleep .0001 until $got || time - $start > 5;
+      die "No signal received\n" unless $got;
+      push @lat, $got - $start;
+   }
+   @lat= sort { $a <=> $b } @lat;
+   return sprintf "%.6f %.6f", $lat[$#lat/2] * 1e3, $lat[-1] * 1e3;
+}
+
+# Each measurement needs a fresh process, so that the heap of the previous one
+# doesn't count.
+sub run_child {
+   my $code= shift;
+   pipe(my $r, my $w) or die "pipe: $!";
+   defined(my $pid= fork) or die "fork: $!";
+   if (!$pid) {
+      close $r;
+      my $out= eval { $code->() };
+      warn $@ if $@;
+      print $w defined $out? $out : '' unless $@;
+      close $w;
+      POSIX::_exit($@? 1 : 0);
+   }
+   close $w;
+   local $/;
+   my $out= <$r>;
+   waitpid($pid, 0);
+   die "child failed\n" if $?;
+   return $out;
+}
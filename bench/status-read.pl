@@ -0,0 +1,55 @@
+#! /usr/bin/env perl
+# Measure the cost of reading an alarm's status, with the watch thread idle
+# and with it busy.
+#
+#   perl -Mblib bench/status-read.pl [n_busy_alarms] [seconds]
+#
+# "busy" means n_busy_alarms alarms on EVENT_CLOSE with a tiny recheck
+# interval, so the watch thread spends nearly all its time holding the mutex
+# while it rechecks them.  Reports calls per second of ->triggered, and the
+# 99.9th percentile and slowest of single calls.
+use strict;
+use warnings;
+use Socket ':all';
+use Time::HiRes qw( time );
+use IO::SocketAlarm;
+use IO::SocketAlarm::Util;
+
+my $n_busy= shift // 2000;
+my $seconds= shift // 2;
+
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $alarm= IO::SocketAlarm->new(socket => $s2);
+$alarm->start;
+
+printf "%8s %14s %12s %12s\n", 'watcher', 'calls/sec', 'p99.9 us', 'max us';
+measure('idle');
+
+IO::SocketAlarm->recheck_interval(0.00001, 0.00001);
+my @busy;
+for (1..$n_busy) {
+   socketpair(my $a, my $b, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   my $x= IO::SocketAlarm->new(socket => $b, events => IO::SocketAlarm::Util::EVENT_CLOSE());
+   $x->start;
+   push @busy, [ $a, $b, $x ];
+}
+measure('busy');
+
+sub measure {
+   my $label= shift;
+   my ($n, @single, $end)= (0);
+   $end= time + $seconds;
+   while (time < $end) {
+      $alarm->triggered for 1..1000;
+      $n += 1000;
+      # also time single calls, which show any wait for the mutex
+      for (1..10) {
+         my $t= time;
+         $alarm->triggered;
+         push @single, time - $t;
+      }
+   }
+   @single= sort { $a <=> $b } @single;
+   printf "%8s %14.0f %12.1f %12.1f\n", $label, $n / $seconds,
+      $single[$#single * .999] * 1e6, $single[-1] * 1e6;
+}
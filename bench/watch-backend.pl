@@ -0,0 +1,83 @@
+#! /usr/bin/env perl
+# Compare the cost of the watch thread's poll() and epoll backends as the
+# number of concurrently watched sockets grows.
+#
+#   perl -Mblib bench/watch-backend.pl [max_watches] [churn_iterations]
+#
+# For each backend and watch count, a child process arms N idle alarms, then
+#  - churn: starts and cancels one more alarm repeatedly, which makes the watch
+#    thread update its state on every call, and reports CPU per start/cancel
+#    (process CPU, which includes the watch thread)
+#  - latency: shuts down the peer of one watched socket and measures the time
+#    until the alarm reports itself as triggered.
+use strict;
+use warnings;
+use Socket ':all';
+use POSIX ();
+use Time::HiRes qw( time sleep clock_gettime CLOCK_PROCESS_CPUTIME_ID );
+use IO::SocketAlarm;
+
+my $max_watches= shift // 4000;
+my $churn= shift // 2000;
+my $fd_limit= (POSIX::sysconf(POSIX::_SC_OPEN_MAX()) || 1024) - 32;
+my @counts= grep $_ <= $max_watches && $_*2 < $fd_limit, 10, 100, 500, 1000, 2000, 4000, 8000;
+
+printf "%-6s %6s %14s %14s\n", 'backend', 'watches', 'churn us/op', 'trigger ms';
+for my $backend (qw( poll epoll )) {
+   next unless eval { run_child(sub { IO::SocketAlarm->watch_backend($backend) }); 1 };
+   for my $n (@counts) {
+      my $result= run_child(sub { measure($backend, $n) });
+      printf "%-6s %6d %14.2f %14.3f\n", $backend, $n, split / /, $result;
+   }
+}
+
+sub measure {
+   my ($backend, $n)= @_;
+   IO::SocketAlarm->watch_backend($backend);
+   local $SIG{ALRM}= sub {};
+   my (@socks, @alarms);
+   for (1..$n) {
+      socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+      push @socks, [ $s1, $s2 ];
+      push @alarms, IO::SocketAlarm->new(socket => $s2, actions => [[ sleep => 0 ]]);
+      $alarms[-1]->start;
+   }
+   socketpair(my $c1, my $c2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   my $churn_alarm= IO::SocketAlarm->new(socket => $c2, actions => [[ sleep => 0 ]]);
+   sleep .05;
+   my $t0= clock_gettime(CLOCK_PROCESS_CPUTIME_ID);
+   for (1..$churn) {
+      $churn_alarm->start;
+      $churn_alarm->cancel;
+   }
+   sleep .05; # let the watch thread catch up on the last wakeups
+   my $cpu= clock_gettime(CLOCK_PROCESS_CPUTIME_ID) - $t0;
+   # Trigger the alarm of a socket in the middle of the list
+   my $victim= int($n/2);
+   my $start= time;
+   shutdown($socks[$victim][0], SHUT_WR);
+   sleep .0001 until $alarms[$victim]->triggered || time - $start > 5;
+   my $latency= time - $start;
+   return sprintf "%.6f %.6f", $cpu / $churn * 1e6, $latency * 1e3;
+}
+
+# Each measurement needs a fresh process, because the backend can't be changed
+# once the watch thread has started.
+sub run_child {
+   my $code= shift;
+   pipe(my $r, my $w) or die "pipe: $!";
+   defined(my $pid= fork) or die "fork: $!";
+   if (!$pid) {
+      close $r;
+      my $out= eval { $code->() };
+      print $w defined $out? $out : '' unless $@;
+      close $w;
+      POSIX::_exit($@? 1 : 0);
+   }
+   close $w;
+   local $/;
+   my $out= <$r>;
+   waitpid($pid, 0);
+   die "child failed\n" if $?;
+   return $out;
+}
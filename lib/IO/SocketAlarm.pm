@@ -7,14 +7,25 @@ use strict;
 use warnings;
 use Carp;
 use Scalar::Util ();
+use Symbol ();
 require XSLoader;
 XSLoader::load('IO::SocketAlarm', $IO::SocketAlarm::VERSION);
 
 # All exports are part of the Util sub-package.
 {package IO::SocketAlarm::Util;
-   our @EXPORT_OK= qw( socketalarm get_fd_table_str is_socket );
+   our @EXPORT_OK= qw( socketalarm get_fd_table_str is_socket close_watched
+      capture_sigqueue sigqueue_values );
    use Exporter 'import';
-   # Declared in XS
+   # Declared in XS, except:
+
+   sub close_watched(;*) {
+      my $fh= @_? $_[0] : select;
+      $fh= Symbol::qualify_to_ref($fh, scalar caller) unless ref $fh;
+      my $fd= fileno($fh);
+      my $ret= CORE::close($fh);
+      IO::SocketAlarm::_fd_closed($fd) if defined $fd && $fd >= 0;
+      return $ret;
+   }
 }
 
 sub import {
@@ -63,6 +74,8 @@ blocking in a long-running database call, this module is for you.
 
 This module operates by creating a second C-level thread (regardless of whether your perl was
 compiled with threading support) and having that thread monitor the status of your socket.
+The actions of triggered alarms run on a few more C-level threads, so that a slow action doesn't
+hold up the others.
 
 B<First caveat:> The background thread is limited in the types of actions it can take.
 For example, you definitely can't run perl code in response to the status change, but it can
@@ -142,6 +155,11 @@ sub new {
 
 =head2 Attributes
 
+=head3 id
+
+A small integer that is unique among the alarms of this process.  It is the default value
+sent by the C<sigqueue> action.
+
 =head3 socket
 
 The C<$socket> must be an operating system level socket (having a 'fileno', as opposed to a
@@ -177,6 +195,26 @@ The available actions are:
 
 Send yourself a signal. The signal constants come from C<< use POSIX ':signal_h'; >>.
 
+=item sig_thread
+
+  [ sig_thread => $signal ],
+
+Like C<sig>, but the signal goes to the thread that created the alarm (using C<tgkill> on Linux,
+or C<pthread_kill>) instead of to whichever thread of the process the kernel picks.  In a
+process where a library has started threads of its own, only this makes sure that a system
+call blocking in perl's thread returns C<EINTR> right away.
+
+=item sigqueue
+
+  [ sigqueue => $signal ],
+  [ sigqueue => $signal, $value ],
+
+Send yourself a signal with C<sigqueue>, carrying an integer C<$value> which defaults to the
+alarm's L</id>.  When several alarms share a (realtime) signal, the handler can use
+L<sigqueue_values|IO::SocketAlarm::Util/sigqueue_values> to learn which ones fired, instead of
+checking every alarm.  On platforms without C<sigqueue>, this is a plain C<kill> without the
+value.
+
 =item kill
 
   [ kill => $signal, $pid ],
@@ -210,6 +248,31 @@ C<< shutdown(fd, $how) >> where C<$how> is one of C<SHUT_RD>, C<SHUT_RW>, C<SHUT
 This leaves the socket open, but causes reads or writes to fail, which may give a more graceful
 cancellation of whatever was happening over that socket.
 
+=item write
+
+  [ write => $fd_or_handle, $bytes ],
+
+Write C<$bytes> to a file descriptor, such as the write end of a self-pipe or an eventfd
+that an event loop or a blocking C library is waiting on.  This wakes it directly, without
+the delay of a signal waiting for perl's next safe point, or colliding with other users of
+C<$SIG{ALRM}>.  The bytes are copied when the alarm is created, and must not contain wide
+characters.  For an eventfd, write 8 bytes, like C<pack("Q", 1)>.  The fd is written in
+blocking mode as usual, and a short write is continued until all the bytes are written.
+
+=item send
+
+  [ send => $sockaddr, $payload ],
+  [ send => $sockaddr, $payload, $timeout_seconds ],
+
+Connect to a server and send it C<$payload>, such as a prebuilt request that cancels whatever
+the server is doing for this worker.  C<$sockaddr> is a packed inet, inet6, or unix socket
+address, like from C<pack_sockaddr_in> or C<getpeername>.  The connect and the send must
+finish within C<$timeout_seconds> (default 2), and then the next action begins regardless.
+The background thread keeps the connection open for the rest of that time, discarding any
+reply, until the server closes it, because closing it first could reset the connection
+before the server reads the payload.  Errors are reported on C<STDERR>.  This delivers a
+small message in far less time than running a program with C<run>.
+
 =item run
 
   [ run => @argv ],
@@ -219,7 +282,26 @@ connected to /dev/null on STDIN.  The double-fork (and reap of first forked chil
 (grand)child process to run independently from the current process, and get reaped by C<init>,
 and not tangle up whatever you might be doing with C<waitpid>.  If the C<exec> fails, it is
 reported on C<STDERR>, but the current process has no way to inspect the outcome of the C<exec>
-or the exit status of the program it runs.
+or the exit status of the program it runs.  (see C<spawn> for that)
+
+On Linux, the two steps are done with C<vfork> and C<posix_spawn> instead of C<fork>, so that
+starting the program doesn't need to copy the page tables of a large perl process.
+
+=item spawn
+
+  [ spawn => @argv ],
+
+Like C<run>, but the program remains a child of the current process, and its exit status is
+available from L</action_results> once it exits.  The next action starts right away, without
+waiting for the program to finish.
+
+On Linux, the child is started with C<clone> without an exit signal, so it doesn't send
+C<SIGCHLD> and isn't visible to C<wait> or C<< waitpid(-1, ...) >>, and the watch thread reaps
+it when its pidfd becomes readable.  If C<exec> fails, the status is C<< 127 << 8 >>.  Linux
+before 5.2 has no pidfds, so the executor thread blocks in C<waitpid> for the child instead,
+and the actions after it wait for it to exit.  On other platforms it is a plain C<fork>, and
+the executor thread blocks in C<waitpid> for it the same way, so a C<SIGCHLD> handler that
+reaps every child could steal the status.
 
 =item exec
 
@@ -235,20 +317,35 @@ just immediately C<exit>s.
 
   [ sleep => $seconds ],
 
-Wait before running the next action.
+Wait before running the next action.  C<$seconds> may be fractional, and the wait is
+timed with sub-millisecond precision on Linux and FreeBSD.
 
 =back
 
+Instead of an arrayref, C<actions> may be an L<IO::SocketAlarm::Actions> object, which parses
+the actions once so that any number of alarms can share them.
+
 =head3 action_count
 
 Shortcut for C<< scalar @actions >>, but avoids inflating the arrayref of actions.
 
+=head3 action_results
+
+  my $statuses= $alarm->action_results;
+
+Returns an arrayref parallel to L</actions>.  For each C<spawn> action whose program has
+exited, the element is its wait status, in the same format as C<$?>.  All other elements are
+C<undef>.
+
 =head3 cur_action
 
 Returns -1 if the alarm is not yet triggered, else the number of the action being executed,
 ending with the integer beyond the max element of L</actions>.  Note that by the time your
 script reads this attribute, it may already have changed.
 
+Reading this (or L</triggered> or L</finished>) never waits for the background threads, so
+it is cheap enough to check in a tight loop.
+
 =head3 triggered
 
 Shortcut for C<< $cur_action >= 0 >>
@@ -257,11 +354,6 @@ Shortcut for C<< $cur_action >= 0 >>
 
 Shortcut for C<< $cur_action > $#actions >>
 
-=cut
-
-sub triggered { $_[0]->cur_action >= 0 }
-sub finished { $_[0]->cur_action >= $_[0]->action_count }
-
 =head2 Methods
 
 =head3 start
@@ -272,12 +364,145 @@ prior to this call. (i.e. whether the call changed the state of the alarm)
 =head3 cancel
 
 Stop listening for the alarm events.  Returns a boolean of whether the alarm was active prior
-to this call.  (i.e. whether the call changed the state of the alarm)
+to this call.  (i.e. whether the call changed the state of the alarm)  If the alarm has
+triggered but its actions haven't started, they won't run.  If one of its actions is running,
+this waits for that action to finish, which for C<send> can take up to its timeout if the
+server doesn't accept the connection or the payload.
+
+=head3 rearm
+
+  $alarm->rearm($socket);
+
+Watch a different socket with the same events and actions, without parsing the actions again
+or allocating a new alarm.  This cancels the alarm if it is active (waiting for a running
+action, like L</cancel>), clears its L</action_results>, and starts it again untriggered on
+C<$socket>.  Returns C<$alarm>.  This is useful for a server that keeps one alarm per worker
+and points it at each new connection.
+
+=head3 reset
+
+Like L</rearm>, but keeps watching the current socket.
 
 =head3 stringify
 
 Render the alarm as user-readable text, for diagnosis and logging.
 
+=head2 Class Methods
+
+=head3 start_all
+
+  $n= IO::SocketAlarm->start_all(@alarms);
+
+Same as calling L</start> on each alarm, but takes the lock on the list of watched alarms
+once and wakes the background thread once.  Returns how many of the alarms were not already
+active.  Dies without starting any of them if one is not an alarm.
+
+=head3 cancel_all
+
+  $n= IO::SocketAlarm->cancel_all(@alarms);
+
+Same as calling L</cancel> on each alarm, with one lock and wakeup.  Returns how many of the
+alarms were active.
+
+=head3 watch_backend
+
+  $name= IO::SocketAlarm->watch_backend;
+  IO::SocketAlarm->watch_backend('poll');
+
+Get or set the mechanism the background thread uses to wait on sockets.  On Linux the default
+is C<'epoll'>, which registers each socket with the kernel once when the alarm starts and
+removes it once when the alarm is cancelled, so that the cost of starting or cancelling an
+alarm doesn't depend on how many other alarms are active.  C<'poll'> is available everywhere,
+and updates its list of sockets only for the alarms that changed.
+
+The backend can only be changed before the first alarm is started, because the background
+thread keeps using the same one until the program exits.
+
+=head3 drain_triggered
+
+  my @fired= IO::SocketAlarm->drain_triggered;
+
+Return the alarm objects that triggered since the last call, in the order they triggered.
+Each alarm is returned once per trigger, and alarms that have been freed are left out.  Code
+that manages many alarms can use this instead of checking L</triggered> on each of them.
+
+=head3 notify_fd
+
+  my $fd= IO::SocketAlarm->notify_fd;
+  open my $fh, '<&=', $fd or die;
+  my $w= AnyEvent->io(fh => $fh, poll => 'r', cb => sub {
+    for my $alarm (IO::SocketAlarm->drain_triggered) { ... }
+  });
+
+Return a file descriptor (an eventfd on Linux, else a pipe) that is readable whenever
+triggered alarms are waiting for L</drain_triggered>, which also resets it.  An event loop
+can watch this one descriptor to learn about alarms, without any signal handler.  Don't read
+from it yourself.  It is created on the first call, and is the same for the whole process.
+
+=head3 pool_stats
+
+  my $stats= IO::SocketAlarm->pool_stats;
+  # { hits => ..., misses => ..., released => ..., cached => ... }
+
+Alarm objects are allocated from free lists of a few size classes, so that a process which
+creates and destroys alarms at a high rate reuses the same memory instead of calling malloc.
+This returns counters of allocations served from the free lists (C<hits>) or by malloc
+(C<misses>), of frees given back to malloc because a free list was full or the alarm was too
+large to pool (C<released>), and the number of blocks currently on the free lists (C<cached>).
+
+=head3 start_spawn_helper
+
+  my $helper_pid= IO::SocketAlarm->start_spawn_helper;
+
+Fork a small helper process that starts the programs of C<run> actions on behalf of this one,
+and return its pid.  (or the pid of the one already running)  Call it early, while the process
+is still small and before starting any alarms; a pre-forking server can call it in the parent
+so that all of its workers share one helper.  The background thread then sends each C<run>
+command over a unix socket, and starting it costs the same no matter how large the worker
+has grown.  If the helper can't take the command right away, or has exited, the background
+thread starts the program itself as usual.
+
+The helper closes every file descriptor except STDOUT and STDERR, so it doesn't keep any
+connections open, and exits when every process using it has exited.  C<exec> and C<spawn>
+actions don't use it, since their program needs to replace or be a child of this process.
+This is available on Linux and FreeBSD.
+
+Commands started by the helper inherit I<its> environment, current directory, umask, resource
+limits, user and group as of when it was forked, not those of the process whose alarm fired.
+Later changes to C<%ENV>, C<chdir>, C<umask> and so on in the perl process don't affect them,
+so don't use the helper if the commands depend on any of those changing.  (pass them
+explicitly, e.g. C<< [ run => 'env', "VAR=$value", ... ] >>, or with C<sh -c 'cd ... && ...'>)
+
+=head3 hook_close
+
+  IO::SocketAlarm->hook_close;
+
+Install L<close_watched|IO::SocketAlarm::Util/close_watched> as C<CORE::GLOBAL::close>, so
+that every C<close> in code compiled after this call notifies the background thread, and
+alarms on L<EVENT_CLOSE|IO::SocketAlarm::Util/EVENT_CLOSE> trigger right away instead of at
+their next L</recheck_interval>.  Call it from a C<BEGIN> block before loading the code whose
+C<close> calls should be seen.  Handles that get closed implicitly, such as by going out of
+scope, are still only found by the recheck.
+
+=cut
+
+sub hook_close {
+   no warnings 'redefine';
+   *CORE::GLOBAL::close= \&IO::SocketAlarm::Util::close_watched;
+}
+
+=head3 recheck_interval
+
+  ($min, $max)= IO::SocketAlarm->recheck_interval;
+  IO::SocketAlarm->recheck_interval(0.01, 1);
+
+Get or set the range of intervals (in seconds) at which the background thread re-examines a
+socket whose condition can't be waited for: alarms on L<EVENT_CLOSE|IO::SocketAlarm::Util/EVENT_CLOSE>,
+and alarms on L<EVENT_EOF|IO::SocketAlarm::Util/EVENT_EOF> while the socket has unread data.
+Each such alarm is first checked C<$min> seconds after it starts (or enters that state), and
+then the interval doubles after each check up to C<$max>.  Other alarms are not affected.
+The defaults are 0.05 and 0.5.  New settings apply from each alarm's next check.
+
 =cut
 
 # Before global destruction, de-activate the alarms and ask the watcher thread to terminate.
@@ -0,0 +1,56 @@
+# PODNAME: IO::SocketAlarm::Actions
+# This package is defined in XS loaded by IO::SocketAlarm.
+# This file stub exists for documentation and to allow 'use ...Actions'
+require IO::SocketAlarm;
+
+__END__
+
+=head1 SYNOPSIS
+
+  use IO::SocketAlarm qw( socketalarm );
+  my $on_disconnect= IO::SocketAlarm::Actions->new(
+    [ sig => SIGALRM ],
+    [ run => '/usr/local/bin/log-disconnect', $$ ],
+  );
+  ...
+  for my $client (@clients) {
+    $alarm{$client}= socketalarm($client, $on_disconnect);
+    # or
+    $alarm{$client}= IO::SocketAlarm->new(socket => $client, actions => $on_disconnect);
+  }
+
+=head1 DESCRIPTION
+
+An immutable list of L<actions|IO::SocketAlarm/actions>, parsed once.  Alarms created from it
+refer to its strings, argument lists and socket addresses instead of parsing and copying them,
+so creating an alarm is cheap and the memory used by many alarms with the same actions stays
+small.  The parsed actions stay alive until the object and all alarms created from it are gone.
+
+Actions that signal "yourself" target the process that created this object, and
+C<sig_thread> the thread that created it, rather than those that create each alarm.  After a
+C<fork>, the child should create its own.
+
+=head1 CONSTRUCTOR
+
+=head2 new
+
+  $actions= IO::SocketAlarm::Actions->new(@actions);
+
+Parse the action specifications, which are the same as for
+L<IO::SocketAlarm/actions>.  With no actions, the default C<< [ sig => SIGALRM ] >> is used.
+
+=head1 ATTRIBUTES
+
+=head2 actions
+
+Returns a read-only arrayref of the action specifications, as they were understood.
+
+=head2 action_count
+
+Number of actions.
+
+=head2 alarm_count
+
+Number of alarms currently using these actions.
+
+=cut
@@ -22,6 +22,8 @@ This is a shortcut for L<IO::SocketAlarm-E<gt>new|IO::SocketAlarm/new>:
   );
   $alarm->start;
 
+The C<@actions> may also be a single L<IO::SocketAlarm::Actions> object.
+
 =head2 is_socket
 
   $bool= is_socket($thing);
@@ -30,6 +32,34 @@ Returns true if and only if the parameter is a socket at the operating system le
 (for instance, the socket must not have been C<close>d, which would release that file
 descriptor) It permits file handles or file descriptor numbers.
 
+=head2 close_watched
+
+  close_watched($socket);
+
+Same as C<close>, but if any alarms are watching the file descriptor for
+L</EVENT_CLOSE>, the background thread is told about it right away so that they trigger
+immediately, rather than at their next L<recheck|IO::SocketAlarm/recheck_interval>.  See also
+L<IO::SocketAlarm/hook_close>, which makes this the global C<close>.
+
+=head2 capture_sigqueue
+
+  my $sig= POSIX::SIGRTMIN();
+  $SIG{RTMIN}= sub { my @ids= sigqueue_values($sig); ... };
+  capture_sigqueue($sig);
+
+Perl doesn't pass the value sent by C<sigqueue> to C<%SIG> handlers, so this installs a C
+signal handler ahead of perl's that records the value for L</sigqueue_values>, then lets perl
+handle the signal as usual.  Call it B<after> assigning C<$SIG{...}>, because assigning
+C<%SIG> replaces it.  Up to 64 values are kept per signal until they are read.
+
+=head2 sigqueue_values
+
+  @values= sigqueue_values($signal);
+
+Return and remove the values received with C<$signal> since the last call, oldest first.
+With the L<sigqueue|IO::SocketAlarm/sigqueue> action's default value, these are the
+L<id|IO::SocketAlarm/id>s of the alarms that fired.
+
 =head2 get_fd_table_str
 
   $str= get_fd_table();        // scans fd 0..1023
@@ -65,8 +95,10 @@ Triggers when the file handle indicates EOF by a successful zero-length read.  T
 by performing a C<< recv(sock, buf, len, MSG_PEEK|MSG_DONTWAIT) >> so that no actual data is
 removed from the socket.  If your peer writes data to the socket before closing it, you won't
 get this event until you read that data.  There is no efficient way to wait for this event when
-the peer has sent additional data; this module falls back to checking at short intervals in that
-case, which is inefficient and may fail to deliver the event when you need it delivered.
+the peer has sent additional data; this module falls back to checking that socket at intervals
+(see L<IO::SocketAlarm/recheck_interval>) in that case, which may delay the event.  On Linux,
+those checks only begin after the peer has shut down its side of the connection, which can be
+waited for efficiently.
 
 But again, this generally works in a HTTP worker pool where this module is intended to be used.
 
@@ -83,8 +115,14 @@ POLLPRI flag on the call to poll().
 =item EVENT_CLOSE
 
 Triggers when another thread on this application has called "close" on the socket file handle.
-More specifically, it triggers when "stat()" fails or reports a different device or inode for
-the file descriptor, indicating that descriptor number has been closed or recycled.
+More specifically, it triggers when the file descriptor no longer refers to the same socket,
+indicating that descriptor number has been closed or recycled.  On Linux this compares the
+socket's C<SO_COOKIE>, and elsewhere the device and inode reported by "stat()".  Closing a
+file descriptor doesn't wake up any other thread, so this is checked at intervals (see
+L<IO::SocketAlarm/recheck_interval>).
+
+If the socket is closed with L</close_watched> (or with C<close> after
+L<IO::SocketAlarm/hook_close>), the event is delivered immediately.
 
 (it is a better idea to make sure you cancel the alarm before returning to any code which might
  close your end of the socket)
@@ -0,0 +1,26 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use IO::SocketAlarm::Util;
+use Socket ":all";
+use Time::HiRes 'sleep';
+
+is( [ IO::SocketAlarm->recheck_interval(0.01, 0.05) ], [ 0.01, 0.05 ], 'set recheck_interval' );
+like( dies { IO::SocketAlarm->recheck_interval(0.5, 0.1) }, qr/min <= max/, 'min must not exceed max' );
+
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0);
+my @got_alarm;
+local $SIG{ALRM}= sub { note "Got alarm"; push @got_alarm, 'ontime' };
+my $alarm= IO::SocketAlarm->new(socket => $s2, events => IO::SocketAlarm::Util::EVENT_CLOSE());
+$alarm->start;
+sleep .2;
+ok( !$alarm->triggered, 'not triggered while socket open' );
+close($s2);
+# 50ms max interval; allow plenty of slack for slow hosts
+for (1..20) { last if $alarm->triggered; sleep .05 }
+ok( $alarm->triggered, 'triggered after close' );
+sleep .1;
+is( \@got_alarm, ['ontime'], 'got signal' );
+
+done_testing;
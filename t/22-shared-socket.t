@@ -0,0 +1,36 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use IO::SocketAlarm::Util;
+use Socket ":all";
+use Time::HiRes 'sleep';
+
+# Two alarms watching different events on the same socket must both get their
+# events from the kernel.
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0);
+my @got;
+local $SIG{USR1}= sub { note "Got USR1"; push @got, 'in' };
+local $SIG{USR2}= sub { note "Got USR2"; push @got, 'eof' };
+my $on_in= IO::SocketAlarm->new(socket => $s2, events => IO::SocketAlarm::Util::EVENT_IN(),
+   actions => [[ sig => 'SIGUSR1' ]]);
+my $on_eof= IO::SocketAlarm->new(socket => $s2, events => IO::SocketAlarm::Util::EVENT_EOF(),
+   actions => [[ sig => 'SIGUSR2' ]]);
+$on_in->start;
+$on_eof->start;
+sleep .1;
+is( \@got, [], 'no events yet' );
+
+syswrite($s1, "x");
+for (1..20) { last if $on_in->triggered; sleep .05 }
+ok( $on_in->triggered, 'EVENT_IN alarm triggered' );
+ok( !$on_eof->triggered, 'EVENT_EOF alarm waiting' );
+
+sysread($s2, my $buf, 1);
+shutdown($s1, SHUT_WR);
+for (1..20) { last if $on_eof->triggered; sleep .05 }
+ok( $on_eof->triggered, 'EVENT_EOF alarm triggered' );
+sleep .1;
+is( \@got, ['in', 'eof'], 'got both signals' );
+
+done_testing;
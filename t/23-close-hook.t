@@ -0,0 +1,40 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm 'close_watched';
+use IO::SocketAlarm::Util;
+use Socket ":all";
+use Time::HiRes 'sleep', 'time';
+
+BEGIN { IO::SocketAlarm->hook_close }
+
+# Make the polling fallback too slow to be what triggers the alarms
+IO::SocketAlarm->recheck_interval(5, 5);
+
+sub close_latency {
+   my $close= shift;
+   socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0);
+   my $alarm= IO::SocketAlarm->new(socket => $s2, events => IO::SocketAlarm::Util::EVENT_CLOSE(),
+      actions => [[ sig => 'SIGUSR1' ]]);
+   $alarm->start;
+   my $got;
+   local $SIG{USR1}= sub { $got= time };
+   my $t0= time;
+   $close->($s2);
+   sleep .01 until $got || time - $t0 > 2;
+   return $got? $got - $t0 : undef;
+}
+
+my $t= close_latency(sub { close_watched($_[0]) });
+ok( defined $t && $t < 1, 'close_watched' ) or note "latency: ".($t // 'none');
+$t= close_latency(sub { close $_[0] });
+ok( defined $t && $t < 1, 'hooked close' ) or note "latency: ".($t // 'none');
+
+# bareword handles still work through the hook
+socketpair(SOCK1, SOCK2, AF_UNIX, SOCK_STREAM, 0);
+ok( close(SOCK1), 'close bareword' );
+ok( !defined fileno(SOCK1), 'bareword closed' );
+ok( close_watched(*SOCK2), 'close glob' );
+ok( !defined fileno(SOCK2), 'glob closed' );
+
+done_testing;
@@ -0,0 +1,65 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use IO::SocketAlarm::Util;
+use Socket ":all";
+use IO::Socket;
+use Time::HiRes 'sleep';
+
+# EVENT_EOF can't happen while the peer's data sits unread in our socket.
+# Check that it still gets delivered once the application reads it, whether
+# the peer shuts down before or after that.
+
+sub tcp_socketpair;
+sub wait_triggered {
+   my $alarm= shift;
+   for (1..40) { last if $alarm->triggered; sleep .05 }
+   return $alarm->triggered;
+}
+
+for my $type ('UNIX', 'TCP') {
+   my ($s1, $s2)= $type eq 'TCP'? tcp_socketpair
+      : do { socketpair(my $a, my $b, AF_UNIX, SOCK_STREAM, 0) or die; ($a, $b) };
+   local $SIG{ALRM}= sub { note "Got alarm" };
+   syswrite($s1, "data");
+   my $alarm= IO::SocketAlarm->new(socket => $s2, events => IO::SocketAlarm::Util::EVENT_EOF());
+   $alarm->start;
+   sleep .1;
+   shutdown($s1, SHUT_WR);
+   sleep .2;
+   ok( !$alarm->triggered, "$type: not triggered while data is unread" );
+   sysread($s2, my $buf, 4);
+   ok( wait_triggered($alarm), "$type: triggered after reading the data" );
+
+   ($s1, $s2)= $type eq 'TCP'? tcp_socketpair
+      : do { socketpair(my $a, my $b, AF_UNIX, SOCK_STREAM, 0) or die; ($a, $b) };
+   syswrite($s1, "data");
+   $alarm= IO::SocketAlarm->new(socket => $s2, events => IO::SocketAlarm::Util::EVENT_EOF());
+   $alarm->start;
+   sleep .1;
+   sysread($s2, $buf, 4);
+   sleep .1;
+   ok( !$alarm->triggered, "$type: not triggered before shutdown" );
+   shutdown($s1, SHUT_WR);
+   ok( wait_triggered($alarm), "$type: triggered after shutdown" );
+}
+
+my $tcp_listen;
+sub tcp_socketpair {
+   unless ($tcp_listen) {
+      socket $tcp_listen, AF_INET, SOCK_STREAM, 0
+         or die "socket: $!";
+      listen $tcp_listen, 10
+         or die "listen: $!";
+   }
+   socket my $sc, AF_INET, SOCK_STREAM, 0
+      or die "socket: $!";
+   connect $sc, getsockname $tcp_listen
+      or die "connect: $!";
+   accept my $ss, $tcp_listen
+      or die "accept: $!";
+   return ($sc, $ss);
+}
+
+done_testing;
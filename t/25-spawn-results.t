@@ -0,0 +1,56 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use POSIX ':sys_wait_h';
+use Time::HiRes 'sleep';
+
+my $sh= (grep -x, '/bin/sh', '/usr/bin/sh')[0]
+   or skip_all "Can't find 'sh'";
+
+sub wait_results {
+   my ($alarm, $n)= @_;
+   for (1..40) {
+      last if $n == grep defined, @{ $alarm->action_results };
+      sleep .05;
+   }
+   return $alarm->action_results;
+}
+
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $got_usr1;
+local $SIG{USR1}= sub { $got_usr1++ };
+my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [
+   [ spawn => $sh, -c => 'exit 3' ],
+   [ spawn => $sh, -c => 'kill -TERM $$' ],
+   [ sig => 'SIGUSR1' ],
+   [ spawn => '/nonexistent/command' ],
+]);
+is( $alarm->actions->[0], [ spawn => $sh, -c => 'exit 3' ], 'spawn action inflates' );
+is( $alarm->action_results, [ undef, undef, undef, undef ], 'no results before trigger' );
+$alarm->start;
+shutdown($s1, SHUT_WR);
+my $results= wait_results($alarm, 3);
+is( $results, [ 3 << 8, POSIX::SIGTERM(), undef, 127 << 8 ], 'exit statuses' )
+   or note explain $results;
+sleep .1 unless $got_usr1;
+ok( $got_usr1, 'actions after spawn still ran' );
+# perl's own child handling doesn't see them
+is( waitpid(-1, WNOHANG), -1, 'no children visible to waitpid(-1)' );
+
+# Freeing the alarm while its child runs doesn't disturb the watch thread
+socketpair($s1, $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+$alarm= IO::SocketAlarm->new(socket => $s2, actions => [[ spawn => $sh, -c => 'sleep 0.2' ]]);
+$alarm->start;
+shutdown($s1, SHUT_WR);
+sleep .05 until $alarm->finished;
+undef $alarm;
+sleep .4;
+socketpair($s1, $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+$alarm= IO::SocketAlarm->new(socket => $s2, actions => [[ spawn => $sh, -c => 'exit 0' ]]);
+$alarm->start;
+shutdown($s1, SHUT_WR);
+is( wait_results($alarm, 1), [ 0 ], 'next spawn reports its status' );
+
+done_testing;
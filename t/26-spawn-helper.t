@@ -0,0 +1,41 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use File::Temp 'tempdir';
+use Time::HiRes 'sleep';
+
+my $sh= (grep -x, '/bin/sh', '/usr/bin/sh')[0]
+   or skip_all "Can't find 'sh'";
+my $helper= eval { IO::SocketAlarm->start_spawn_helper }
+   or skip_all "No spawn helper: $@";
+
+ok( kill(0, $helper), 'helper is running' );
+is( IO::SocketAlarm->start_spawn_helper, $helper, 'second call returns the same helper' );
+
+# The stand-in command records which process started it
+my $dir= tempdir(CLEANUP => 1);
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $got_usr1;
+local $SIG{USR1}= sub { $got_usr1++ };
+my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [
+   [ run => $sh, -c => "s=closed; [ -e /proc/\$\$/fd/3 ] && s=open; echo \$s > $dir/fd3;"
+      . " echo \$PPID > $dir/ppid.tmp && mv $dir/ppid.tmp $dir/ppid && kill -USR1 $$" ],
+]);
+$alarm->start;
+shutdown($s1, SHUT_WR);
+for (1..40) { last if $got_usr1; sleep .05 }
+ok( $got_usr1, 'command ran' );
+open my $fh, '<', "$dir/ppid" or die "open: $!";
+chomp(my $ppid= <$fh>);
+is( $ppid, $helper, 'started by the helper' );
+
+# The helper's socket (fd 3) is not passed on to the commands
+if (-d "/proc/$$/fd") {
+   open my $fh, '<', "$dir/fd3" or die "open: $!";
+   chomp(my $fd3= <$fh>);
+   is( $fd3, 'closed', "command doesn't inherit the helper's socket" );
+}
+
+done_testing;
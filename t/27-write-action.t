@@ -0,0 +1,31 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use IO::Select;
+
+pipe(my $r, my $w) or die "pipe: $!";
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [
+   [ write => $w, "wake" ],
+   [ write => fileno($w), "\0up\n" ],
+]);
+is( $alarm->actions, [ [ write => fileno($w), "wake" ], [ write => fileno($w), "\0up\n" ] ], 'actions' );
+like( $alarm->stringify, qr/write 4 bytes to \d+/, 'stringify' );
+$alarm->start;
+ok( !IO::Select->new($r)->can_read(.2), 'nothing written before trigger' );
+shutdown($s1, SHUT_WR);
+ok( IO::Select->new($r)->can_read(2), 'pipe readable after trigger' );
+my $buf= '';
+while (length $buf < 8 && IO::Select->new($r)->can_read(1)) {
+   sysread($r, $buf, 8 - length $buf, length $buf) or last;
+}
+is( $buf, "wake\0up\n", 'bytes written in order' );
+
+like( dies { IO::SocketAlarm->new(socket => $s2, actions => [[ write => $w ]]) },
+   qr/Expected 2 parameters/, 'missing bytes' );
+like( dies { IO::SocketAlarm->new(socket => $s2, actions => [[ write => 'x', 'y' ]]) },
+   qr/Invalid file descriptor/, 'bad fd' );
+
+done_testing;
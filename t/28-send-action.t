@@ -0,0 +1,78 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use IO::Select;
+use File::Temp 'tempdir';
+use Time::HiRes 'sleep', 'time';
+
+sub trigger {
+   my @actions= @_;
+   socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   my $alarm= IO::SocketAlarm->new(socket => $s2, actions => \@actions);
+   $alarm->start;
+   shutdown($s1, SHUT_WR);
+   return $alarm;
+}
+
+sub receive {
+   my $listen= shift;
+   IO::Select->new($listen)->can_read(2) or return undef;
+   accept(my $conn, $listen) or die "accept: $!";
+   my $buf= '';
+   while (IO::Select->new($conn)->can_read(2)) {
+      sysread($conn, $buf, 1024, length $buf) or last;
+   }
+   return $buf;
+}
+
+# inet
+socket(my $tcp, AF_INET, SOCK_STREAM, 0) or die "socket: $!";
+bind($tcp, pack_sockaddr_in(0, INADDR_LOOPBACK)) or die "bind: $!";
+listen($tcp, 5) or die "listen: $!";
+my $alarm= trigger([ send => getsockname($tcp), "KILL 42\n" ]);
+is( $alarm->actions->[0], [ send => getsockname($tcp), "KILL 42\n", 2 ], 'inflated with default timeout' );
+like( $alarm->stringify, qr/send 8 bytes to inet 127\.0\.0\.1:\d+ within 2\.000s/, 'stringify' );
+is( receive($tcp), "KILL 42\n", 'payload received over inet' );
+
+# unix
+my $path= tempdir(CLEANUP => 1) . '/sock';
+socket(my $unix, AF_UNIX, SOCK_STREAM, 0) or die "socket: $!";
+bind($unix, pack_sockaddr_un($path)) or die "bind: $!";
+listen($unix, 5) or die "listen: $!";
+# keep the alarm, since freeing it before it triggers would cancel it
+$alarm= trigger([ send => pack_sockaddr_un($path), "x" x 100000 ]);
+is( length(receive($unix) // ''), 100000, 'large payload received over unix' );
+
+# A peer that never answers doesn't hold up the next action, or other alarms
+socket(my $slow, AF_INET, SOCK_STREAM, 0) or die "socket: $!";
+bind($slow, pack_sockaddr_in(0, INADDR_LOOPBACK)) or die "bind: $!";
+listen($slow, 20) or die "listen: $!";
+my $got;
+local $SIG{USR1}= sub { $got= time };
+my @slow= map trigger([ send => getsockname($slow), "hello", 1 ]), 1..6;
+sleep .1;
+my $t0= time;
+$alarm= trigger([ send => getsockname($slow), "hello", 1 ], [ sig => 'SIGUSR1' ]);
+sleep .05 until $got || time - $t0 > 3;
+ok( $got && $got - $t0 < .5, 'next action ran without waiting for the peer' )
+   or note "elapsed: ".(($got // time) - $t0);
+
+# but the connection stays open for the peer's reply, until the timeout
+accept(my $conn, $slow) or die "accept: $!";
+my $buf= '';
+sysread($conn, $buf, 1024);
+is( $buf, 'hello', 'payload received by slow peer' );
+my $closed;
+for (1..30) {
+   send($conn, "reply", MSG_NOSIGNAL) or do { $closed= time; last };
+   sleep .1;
+}
+ok( $closed && $closed - $t0 > .5, 'closed after the timeout' )
+   or note "elapsed: ".(($closed // time) - $t0);
+
+like( dies { IO::SocketAlarm->new(socket => $tcp, actions => [[ send => "bogus", "x" ]]) },
+   qr/packed inet, inet6, or unix/, 'invalid address' );
+
+done_testing;
@@ -0,0 +1,33 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Errno 'EINTR';
+use POSIX ();
+use Time::HiRes 'time';
+
+# The signal goes to this thread, and interrupts the blocking read.
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+pipe(my $r, my $w) or die "pipe: $!";
+my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [
+   [ sleep => .2 ],
+   [ sig_thread => 'SIGUSR1' ],
+]);
+is( $alarm->actions->[1], [ sig_thread => POSIX::SIGUSR1() ], 'inflated' );
+like( $alarm->stringify, qr/kill sig=\d+ pid=$$ tid=/, 'stringify' );
+my $got;
+local $SIG{USR1}= sub { $got++ };
+local $SIG{ALRM}= sub { die "timeout\n" };
+alarm 5;
+$alarm->start;
+shutdown($s1, SHUT_WR);
+my $t0= time;
+my $n= sysread($r, my $buf, 1);
+my $err= $!+0;
+alarm 0;
+ok( !defined $n && $err == EINTR, 'read interrupted' ) or note "n=".($n//'undef')." err=$err";
+ok( time - $t0 < 2, 'promptly' );
+ok( $got, 'handler ran' );
+
+done_testing;
@@ -0,0 +1,43 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm qw( capture_sigqueue sigqueue_values );
+use Socket ":all";
+use POSIX ();
+use Config;
+use Time::HiRes 'sleep';
+
+skip_all "sigqueue not supported" unless $^O eq 'linux' || $^O eq 'freebsd';
+my $sig= POSIX::SIGRTMIN() + 1;
+
+# Several alarms share one signal, and the handler learns which fired
+my @fired;
+my $sig_name= (split ' ', $Config{sig_name})[$sig];
+local $SIG{$sig_name}= sub { push @fired, sigqueue_values($sig) };
+capture_sigqueue($sig);
+my (@alarms, @peers);
+for (1..3) {
+   socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   push @peers, $s1;
+   push @alarms, IO::SocketAlarm->new(socket => $s2, actions => [[ sigqueue => $sig ]]);
+   $alarms[-1]->start;
+}
+isnt( $alarms[0]->id, $alarms[1]->id, 'alarm ids are unique' );
+is( $alarms[0]->actions->[0], [ sigqueue => $sig ], 'inflated' );
+shutdown($peers[2], SHUT_WR);
+shutdown($peers[0], SHUT_WR);
+for (1..40) { last if @fired >= 2; sleep .05 }
+is( [ sort { $a <=> $b } @fired ], [ sort { $a <=> $b } $alarms[0]->id, $alarms[2]->id ], 'got ids of the alarms that fired' );
+
+# Explicit value
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+@fired= ();
+my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [[ sigqueue => $sig, 12345 ]]);
+like( $alarm->stringify, qr/sigqueue sig=$sig pid=$$ value=12345/, 'stringify' );
+$alarm->start;
+shutdown($s1, SHUT_WR);
+for (1..40) { last if @fired; sleep .05 }
+is( \@fired, [ 12345 ], 'got explicit value' );
+is( [ sigqueue_values($sig) ], [], 'values were consumed' );
+
+done_testing;
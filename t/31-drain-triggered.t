@@ -0,0 +1,34 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Scalar::Util 'refaddr';
+use Time::HiRes 'sleep';
+
+local $SIG{ALRM}= sub {};
+my (@alarms, @peers);
+for (1..50) {
+   socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   push @peers, $s1;
+   push @alarms, IO::SocketAlarm->new(socket => $s2);
+   $alarms[-1]->start;
+}
+is( [ IO::SocketAlarm->drain_triggered ], [], 'nothing triggered yet' );
+
+shutdown($peers[$_], SHUT_WR) for 7, 3, 30;
+for (1..40) { last if 3 == grep $_->triggered, @alarms; sleep .05 }
+my @fired= IO::SocketAlarm->drain_triggered;
+is( [ sort { $a <=> $b } map refaddr($_), @fired ],
+    [ sort { $a <=> $b } map refaddr($_), @alarms[7, 3, 30] ],
+    'drained the alarms that fired' );
+is( [ IO::SocketAlarm->drain_triggered ], [], 'each is returned once' );
+
+# An alarm freed before it is drained is not returned
+shutdown($peers[$_], SHUT_WR) for 10, 11;
+for (1..40) { last if $alarms[10]->triggered && $alarms[11]->triggered; sleep .05 }
+undef $alarms[10];
+@fired= IO::SocketAlarm->drain_triggered;
+is( [ map refaddr($_), @fired ], [ refaddr($alarms[11]) ], 'freed alarm was dropped from the queue' );
+
+done_testing;
@@ -0,0 +1,31 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use IO::Select;
+use Scalar::Util 'refaddr';
+
+my $fd= IO::SocketAlarm->notify_fd;
+ok( $fd >= 0, 'got notify fd' );
+is( IO::SocketAlarm->notify_fd, $fd, 'same fd each time' );
+open my $fh, '<&=', $fd or die "fdopen: $!";
+my $sel= IO::Select->new($fh);
+ok( !$sel->can_read(.1), 'not readable yet' );
+
+local $SIG{ALRM}= sub {};
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+socketpair(my $s3, my $s4, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $a1= IO::SocketAlarm->new(socket => $s2);
+my $a2= IO::SocketAlarm->new(socket => $s4);
+$_->start for $a1, $a2;
+shutdown($s1, SHUT_WR);
+ok( $sel->can_read(2), 'readable after an alarm triggered' );
+is( [ map refaddr($_), IO::SocketAlarm->drain_triggered ], [ refaddr($a1) ], 'drained it' );
+ok( !$sel->can_read(.1), 'not readable after draining' );
+
+shutdown($s3, SHUT_WR);
+ok( $sel->can_read(2), 'readable again for the next alarm' );
+is( [ map refaddr($_), IO::SocketAlarm->drain_triggered ], [ refaddr($a2) ], 'drained it' );
+
+done_testing;
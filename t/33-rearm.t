@@ -0,0 +1,85 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Scalar::Util 'refaddr';
+use Time::HiRes 'sleep';
+
+my $sh= (grep -x, '/bin/sh', '/usr/bin/sh')[0];
+
+sub wait_finished {
+   my $alarm= shift;
+   for (1..40) { last if $alarm->finished; sleep .05 }
+   return $alarm->finished;
+}
+
+my $got_usr1= 0;
+local $SIG{USR1}= sub { $got_usr1++ };
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [[ sig => 'SIGUSR1' ]]);
+my $actions= $alarm->actions;
+$alarm->start;
+shutdown($s1, SHUT_WR);
+ok( wait_finished($alarm), 'triggered on first socket' );
+
+# Point it at a new connection
+socketpair(my $s3, my $s4, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+is( refaddr($alarm->rearm($s4)), refaddr($alarm), 'rearm returns the alarm' );
+is( $alarm->socket, fileno($s4), 'watching the new socket' );
+ok( !$alarm->triggered, 'untriggered after rearm' );
+is( refaddr($alarm->actions), refaddr($actions), 'same actions' );
+sleep .2;
+ok( !$alarm->triggered, 'old socket no longer watched' );
+shutdown($s3, SHUT_WR);
+ok( wait_finished($alarm), 'triggered on new socket' );
+for (1..20) { last if $got_usr1 >= 2; sleep .05 }
+is( $got_usr1, 2, 'actions ran each time' );
+
+# reset keeps the socket, which is still shut down, so it fires again
+$alarm->reset;
+ok( wait_finished($alarm), 'triggered again after reset' );
+
+# rearm of an alarm that is still waiting moves it to the new socket
+socketpair($s1, $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+socketpair($s3, $s4, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+$alarm->rearm($s2);
+$alarm->rearm($s4);
+shutdown($s1, SHUT_WR);
+sleep .2;
+ok( !$alarm->triggered, 'earlier socket ignored' );
+shutdown($s3, SHUT_WR);
+ok( wait_finished($alarm), 'latest socket triggers' );
+
+# An alarm that fired and was rearmed before being drained is no longer
+# reported for that time, but is once it fires again.
+IO::SocketAlarm->drain_triggered;
+$alarm->reset;
+ok( wait_finished($alarm), 'fired' );
+socketpair($s3, $s4, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+$alarm->rearm($s4);
+is( [ IO::SocketAlarm->drain_triggered ], [], 'rearm removed it from drain_triggered' );
+shutdown($s3, SHUT_WR);
+ok( wait_finished($alarm), 'fired on the new socket' );
+is( [ map refaddr($_), IO::SocketAlarm->drain_triggered ], [ refaddr($alarm) ], 'drained once' );
+
+open my $file, '<', __FILE__ or die "open: $!";
+like( dies { $alarm->rearm($file) }, qr/Not an open socket/, 'rearm requires a socket' );
+
+# Results of 'spawn' actions are cleared
+if ($sh) {
+   socketpair($s1, $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   $alarm= IO::SocketAlarm->new(socket => $s2, actions => [[ spawn => $sh, -c => 'exit 4' ]]);
+   $alarm->start;
+   shutdown($s1, SHUT_WR);
+   for (1..40) { last if defined $alarm->action_results->[0]; sleep .05 }
+   is( $alarm->action_results, [ 4 << 8 ], 'spawn result' );
+   socketpair($s3, $s4, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   $alarm->rearm($s4);
+   is( $alarm->action_results, [ undef ], 'cleared by rearm' );
+   shutdown($s3, SHUT_WR);
+   for (1..40) { last if defined $alarm->action_results->[0]; sleep .05 }
+   is( $alarm->action_results, [ 4 << 8 ], 'spawn result of second run' );
+}
+
+done_testing;
@@ -0,0 +1,60 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm qw( socketalarm );
+use Socket ":all";
+use POSIX ();
+use Time::HiRes 'sleep';
+
+my $sh= (grep -x, '/bin/sh', '/usr/bin/sh')[0];
+
+pipe(my $r, my $w) or die "pipe: $!";
+my $prog= IO::SocketAlarm::Actions->new(
+   [ write => $w, "x" ],
+   [ sig => 'SIGUSR1' ],
+);
+is( $prog->action_count, 2, 'action_count' );
+is( $prog->actions, [ [ write => fileno($w), "x" ], [ kill => POSIX::SIGUSR1(), $$ ] ], 'actions' );
+is( IO::SocketAlarm::Actions->new->actions, [ [ kill => POSIX::SIGALRM(), $$ ] ], 'default action' );
+
+my $got_usr1= 0;
+local $SIG{USR1}= sub { $got_usr1++ };
+my (@peers, @socks, @alarms);
+for (1..100) {
+   socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   push @peers, $s1;
+   push @socks, $s2;
+   push @alarms, $_ & 1? socketalarm($s2, $prog)
+      : IO::SocketAlarm->new(socket => $s2, actions => $prog)->tap_start;
+}
+is( $prog->alarm_count, 100, 'alarm_count' );
+is( $alarms[0]->actions, $prog->actions, 'alarm reports the same actions' );
+
+# The alarms still work after the perl object is gone
+undef $prog;
+shutdown($peers[$_], SHUT_WR) for 5, 50;
+for (1..40) { last if 2 == grep $_->finished, @alarms; sleep .05 }
+is( [ grep $alarms[$_]->finished, 0..$#alarms ], [ 5, 50 ], 'the two alarms fired' );
+sysread($r, my $buf, 10);
+is( $buf, "xx", 'each wrote its bytes' );
+sleep .1 unless $got_usr1;
+ok( $got_usr1, 'signal received' ); # the two may be delivered as one
+@alarms= ();
+
+# Each alarm has its own 'spawn' results
+if ($sh) {
+   $prog= IO::SocketAlarm::Actions->new([ spawn => $sh, -c => 'exit 5' ]);
+   my @pairs= map { socketpair(my $a, my $b, AF_UNIX, SOCK_STREAM, 0) or die; [ $a, $b ] } 1..2;
+   @alarms= map socketalarm($_->[1], $prog), @pairs;
+   shutdown($pairs[0][0], SHUT_WR);
+   for (1..40) { last if defined $alarms[0]->action_results->[0]; sleep .05 }
+   is( $alarms[0]->action_results, [ 5 << 8 ], 'first alarm has a result' );
+   is( $alarms[1]->action_results, [ undef ], 'second does not' );
+}
+
+like( dies { IO::SocketAlarm->new(socket => $peers[0], actions => 5) },
+   qr/Actions must be/, 'actions must be arrayref or program' );
+
+done_testing;
+
+sub IO::SocketAlarm::tap_start { $_[0]->start; $_[0] }
@@ -0,0 +1,35 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $stats= IO::SocketAlarm->pool_stats;
+is( [ sort keys %$stats ], [qw( cached hits misses released )], 'pool_stats keys' );
+
+my $prog= IO::SocketAlarm::Actions->new([ sig => 'SIGUSR1' ], [ run => '/bin/true', 'x' x 100 ]);
+# warm up, then the same blocks are reused
+for (1..2) {
+   my @a= map IO::SocketAlarm->new(socket => $s2, actions => [[ sig => 'SIGUSR1' ]]), 1..10;
+   push @a, map IO::SocketAlarm->new(socket => $s2, actions => $prog), 1..10;
+}
+my $before= IO::SocketAlarm->pool_stats;
+for (1..50) {
+   my @a= map IO::SocketAlarm->new(socket => $s2, actions => [[ sig => 'SIGUSR1' ]]), 1..10;
+   push @a, map IO::SocketAlarm->new(socket => $s2, actions => $prog), 1..10;
+   $_->start for @a;
+}
+my $after= IO::SocketAlarm->pool_stats;
+is( $after->{misses}, $before->{misses}, 'no new allocations in steady state' );
+is( $after->{hits} - $before->{hits}, 1000, 'every alarm came from the pool' );
+ok( $after->{cached} >= 20, 'freed alarms are cached' );
+
+# An alarm too big for the pool still works
+my $big= IO::SocketAlarm->new(socket => $s2, actions => [[ run => '/bin/true', 'x' x 10000 ]]);
+is( $big->actions->[0][2], 'x' x 10000, 'oversized alarm' );
+$before= IO::SocketAlarm->pool_stats;
+undef $big;
+is( IO::SocketAlarm->pool_stats->{released}, $before->{released} + 1, 'oversized block released' );
+
+done_testing;
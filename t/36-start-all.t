@@ -0,0 +1,36 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Time::HiRes 'sleep';
+
+local $SIG{ALRM}= sub {};
+my (@peers, @socks, @alarms);
+for (1..20) {
+   socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+   push @peers, $s1;
+   push @socks, $s2;
+   push @alarms, IO::SocketAlarm->new(socket => $s2);
+}
+$alarms[0]->start;
+is( IO::SocketAlarm->start_all(@alarms), 19, 'start_all counts the newly started' );
+is( IO::SocketAlarm->start_all(@alarms), 0, 'all already started' );
+is( IO::SocketAlarm->start_all(), 0, 'empty list' );
+
+shutdown($peers[$_], SHUT_WR) for 3, 12;
+for (1..40) { last if 2 == grep $_->finished, @alarms; sleep .05 }
+is( [ grep $alarms[$_]->triggered, 0..$#alarms ], [ 3, 12 ], 'started alarms watch their sockets' );
+
+is( IO::SocketAlarm->cancel_all(@alarms[0..9]), 9, 'cancel_all counts the active' );
+shutdown($peers[$_], SHUT_WR) for 5, 15;
+for (1..40) { last if $alarms[15]->triggered; sleep .05 }
+sleep .1;
+ok( !$alarms[5]->triggered, 'cancelled alarm ignored its socket' );
+ok( $alarms[15]->triggered, 'the rest still active' );
+is( IO::SocketAlarm->cancel_all(@alarms), 8, 'cancel the rest' );
+
+like( dies { IO::SocketAlarm->start_all($alarms[0], 'x') }, qr/Not an object/, 'non-alarm' );
+ok( !$alarms[0]->cancel, 'nothing was started by the failed call' );
+
+done_testing;
@@ -0,0 +1,23 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Time::HiRes qw( sleep time );
+
+# start() on an alarm whose executor is just finishing its actions must not
+# reset it underneath the executor.  The socket stays shut down, so every
+# start re-triggers the alarm at once.
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+shutdown($s1, SHUT_WR);
+my $alarm= IO::SocketAlarm->new(socket => $s2, actions => [[ sleep => 0 ], [ sleep => 0 ]]);
+my ($starts, $end)= (0, time + 1);
+while (time < $end) {
+   $starts++ if $alarm->start;
+}
+ok( $starts > 1, "restarted $starts times" );
+for (1..40) { last if $alarm->finished; sleep .05 }
+ok( $alarm->finished, 'last run finished' );
+is( $alarm->cur_action, 2, 'cur_action at the end' );
+
+done_testing;
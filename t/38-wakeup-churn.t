@@ -0,0 +1,27 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Time::HiRes 'time';
+
+# Wakeups from start/cancel must not hold back the events on other sockets
+# that the watch thread collected in the same round.
+# (t/40-poll-backend.t runs this again with the poll backend)
+my $backend= IO::SocketAlarm->watch_backend;
+local $SIG{ALRM}= sub {};
+socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+socketpair(my $s3, my $s4, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $target= IO::SocketAlarm->new(socket => $s2);
+my $churn= IO::SocketAlarm->new(socket => $s4);
+$target->start;
+shutdown($s1, SHUT_WR);
+my $start= time;
+until ($target->triggered || time - $start > 5) {
+   $churn->start;
+   $churn->cancel;
+}
+ok( $target->triggered, "$backend: triggered during start/cancel churn" );
+note sprintf "after %.3fs", time - $start;
+
+done_testing;
@@ -0,0 +1,46 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Time::HiRes 'sleep';
+
+# The user closes a watched socket whose file stays open through a dup (or a
+# child process), then a new socket gets the same fd number.  Readiness of
+# the old socket must not trigger the new socket's alarm, nor keep the watch
+# thread busy.
+local $SIG{ALRM}= sub {};
+socketpair(my $a1, my $a2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+my $old_alarm= IO::SocketAlarm->new(socket => $a2);
+$old_alarm->start;
+open(my $dup, '+<&', $a2) or die "dup: $!";
+my $fd= fileno($a2);
+close($a2);
+
+my ($b1, $b2, $new);
+socketpair($b1, $b2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+$new= fileno($b1) == $fd? $b1 : fileno($b2) == $fd? $b2
+   : skip_all "new socket didn't reuse fd $fd";
+my $new_alarm= IO::SocketAlarm->new(socket => $new);
+$new_alarm->start;
+sleep .1;
+
+# Make the old socket ready, for good
+shutdown($a1, SHUT_WR);
+sleep .3;
+ok( !$new_alarm->triggered, 'new socket on the same fd number not triggered by the old one' );
+
+my @t0= times;
+sleep 1;
+my @t1= times;
+my $cpu= ($t1[0] - $t0[0]) + ($t1[1] - $t0[1]);
+ok( $cpu < 0.3, 'watch thread idle while the old socket stays ready' )
+   or note "cpu: $cpu";
+
+# and the new alarm still works
+my $peer= $new == $b1? $b2 : $b1;
+shutdown($peer, SHUT_WR);
+for (1..40) { last if $new_alarm->triggered; sleep .05 }
+ok( $new_alarm->triggered, 'new alarm triggers on its own socket' );
+
+done_testing;
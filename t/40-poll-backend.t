@@ -0,0 +1,23 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+
+# The backend can only be chosen before the watch thread starts, so the tests
+# of the watch thread run again here, each in a new process using 'poll'.
+# (the rest of the test suite uses the default)
+skip_all "poll is already the default backend"
+   if IO::SocketAlarm->watch_backend eq 'poll';
+
+my @inc= map "-I$_", grep !ref, @INC;
+for my $test (sort grep !/40-poll-backend/, glob 't/[2-9]*.t') {
+   open my $fh, '-|', $^X, @inc, '-MIO::SocketAlarm', '-e',
+      'IO::SocketAlarm->watch_backend("poll"); my $r= do "./$ARGV[0]"; die $@ if $@; die "$ARGV[0]: $!" unless defined $r',
+      $test
+      or die "fork: $!";
+   my $out= do { local $/; <$fh> };
+   ok( close($fh), "$test with poll backend" )
+      or diag $out;
+}
+
+done_testing;
@@ -0,0 +1,30 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Time::HiRes 'sleep';
+
+# poll() has no limit like select's FD_SETSIZE, and neither should the pollset
+IO::SocketAlarm->watch_backend('poll');
+local $SIG{ALRM}= sub {};
+my (@alarms, @peers);
+for (1..1100) {
+   socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0)
+      or skip_all "Can't open enough sockets: $!";
+   push @peers, $s1;
+   push @alarms, IO::SocketAlarm->new(socket => $s2);
+}
+ok( $alarms[-1]->socket > 1024, 'watching fds above 1024' );
+is( IO::SocketAlarm->start_all(@alarms), scalar @alarms, 'started all' );
+sleep .1;
+is( scalar(grep $_->triggered, @alarms), 0, 'none triggered yet' );
+
+my @shut= (5, 600, 1050, 1099);
+shutdown($peers[$_], SHUT_WR) for @shut;
+for (1..40) { last if @shut == grep $_->triggered, @alarms; sleep .05 }
+is( [ grep $alarms[$_]->triggered, 0..$#alarms ], \@shut, 'triggered the right alarms, including fds above 1024' );
+
+is( IO::SocketAlarm->cancel_all(@alarms), @alarms - @shut, 'cancelled the rest' );
+
+done_testing;
@@ -0,0 +1,103 @@
+use Test2::V0;
+use strict;
+use warnings;
+use IO::SocketAlarm;
+use Socket ":all";
+use Time::HiRes 'sleep', 'time';
+
+# The poll backend keeps its pollset between wakeups, and Perl's thread only
+# queues the fds whose alarms changed.  Exercise the updates of that pollset.
+IO::SocketAlarm->watch_backend('poll');
+local $SIG{ALRM}= sub {};
+
+sub pairs {
+   map {
+      socketpair(my $s1, my $s2, AF_UNIX, SOCK_STREAM, 0) or die "socketpair: $!";
+      [ $s1, $s2, IO::SocketAlarm->new(socket => $s2) ]
+   } 1..shift;
+}
+sub wait_triggered {
+   my @alarms= @_;
+   for (1..40) { last if @alarms == grep $_->triggered, @alarms; sleep .05 }
+   return scalar grep $_->triggered, @alarms;
+}
+sub triggered_idx {
+   my $pairs= shift;
+   [ grep $pairs->[$_][2]->triggered, 0..$#$pairs ]
+}
+
+# Removing the first, a middle, and the last slot moves later slots into the
+# holes.  The moved fds must still be watched, and the removed ones not.
+my @p= pairs(20);
+$_->[2]->start for @p;
+sleep .1;
+$p[$_][2]->cancel for 0, 7, 19;
+sleep .1;
+shutdown($_->[0], SHUT_WR) for @p;
+is( wait_triggered(map $p[$_][2], grep !/^(0|7|19)$/, 0..19), 17, 'remaining slots triggered' );
+is( triggered_idx([ @p[0, 7, 19] ]), [], 'removed slots did not' );
+
+# Alarms that finish in the same round remove several slots while the watch
+# thread walks the pollset.
+@p= pairs(20);
+$_->[2]->start for @p;
+sleep .1;
+shutdown($p[$_][0], SHUT_WR) for 2..9;
+is( wait_triggered(map $p[$_][2], 2..9), 8, 'all triggered in one round' );
+sleep .1;
+is( triggered_idx(\@p), [ 2..9 ], 'no others' );
+shutdown($p[$_][0], SHUT_WR) for 0, 1, 10..19;
+is( wait_triggered(map $_->[2], @p), 20, 'the rest still watched after compaction' );
+
+# An fd removed and added again before the watch thread applies the first
+# change is queued once, with its final state.
+@p= pairs(10);
+$_->[2]->start for @p;
+sleep .1;
+for (1..50) {
+   $_->[2]->cancel, $_->[2]->start for @p;
+}
+sleep .1;
+is( triggered_idx(\@p), [], 'nothing triggered by cancel/start' );
+shutdown($p[$_][0], SHUT_WR) for 3, 6;
+is( wait_triggered($p[3][2], $p[6][2]), 2, 'still watched after cancel/start churn' );
+$p[$_][2]->cancel for 0, 1;
+$p[$_][2]->start for 0;
+shutdown($p[$_][0], SHUT_WR) for 0, 1;
+is( wait_triggered($p[0][2]), 1, 're-added fd triggered' );
+sleep .1;
+ok( !$p[1][2]->triggered, 'removed fd did not' );
+
+# The same fd number, closed and reused by a new socket, while the wakeup for
+# removing it is pending
+@p= ();
+@p= pairs(3);
+$_->[2]->start for @p;
+sleep .1;
+my $fd= fileno($p[1][1]);
+$p[1][2]->cancel;
+undef $p[1];
+my ($new)= pairs(1);
+is( fileno($new->[1]), $fd, 'reused fd number' );
+$new->[2]->start;
+sleep .1;
+ok( !$new->[2]->triggered, 'new socket not triggered' );
+shutdown($new->[0], SHUT_WR);
+is( wait_triggered($new->[2]), 1, 'new socket on the reused fd triggered' );
+
+# Start/cancel churn on many fds doesn't hold back the ones that are ready
+@p= pairs(30);
+my @targets= @p[0..4];
+$_->[2]->start for @targets;
+my $start= time;
+my $n= 0;
+until (5 == grep($_->[2]->triggered, @targets) || time - $start > 5) {
+   shutdown($targets[$n++][0], SHUT_WR) if $n < 5;
+   $_->[2]->start for @p[5..29];
+   $_->[2]->cancel for @p[5..29];
+}
+is( scalar(grep $_->[2]->triggered, @targets), 5, 'triggered during start/cancel churn' );
+is( triggered_idx([ @p[5..29] ]), [], 'churned alarms not triggered' );
+note sprintf "after %.3fs", time - $start;
+
+done_testing;